@@ -0,0 +1,495 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define AGGREGATE_AVX2
+#include <immintrin.h>
+#endif
+
+#include "aggregate.hpp"
+
+namespace JSON {
+
+    namespace {
+
+        // every thread gets at least this many numbers
+        constexpr std::size_t PARALLEL_CHUNK = 1 << 20;
+
+        // the exact sum of 64-bit integers
+        using Wide = __int128;
+
+        /**
+         * What one kernel gathers over part of the input, merged with the
+         * other parts before it is rounded into an Aggregate
+         * */
+        template<typename T>
+        struct Partial {
+            using Sum = std::conditional_t<std::is_integral_v<T>, Wide, double>;
+
+            std::size_t count = 0;
+            Sum sum = 0;
+            T min = std::numeric_limits<T>::max();
+            T max = std::numeric_limits<T>::lowest();
+
+            void add(T value) {
+                ++count;
+                sum += value;
+                min = std::min(min, value);
+                max = std::max(max, value);
+            }
+
+            void merge(const Partial &other) {
+                count += other.count;
+                sum += other.sum;
+                min = std::min(min, other.min);
+                max = std::max(max, other.max);
+            }
+        };
+
+        // the bounds of a Range in the type of the numbers
+        template<typename T>
+        struct Bounds {
+            T low;
+            T high;
+            bool empty;
+
+            bool contains(T value) const {
+                return value >= low && value <= high;
+            }
+        };
+
+        Bounds<double> boundsOf(const Range &range, double) {
+            return { range.low, range.high, !(range.low <= range.high) };
+        }
+
+        Bounds<std::int64_t> boundsOf(const Range &range, std::int64_t) {
+            // 2^63, the first double past the integers
+            constexpr double LIMIT = 9223372036854775808.0;
+
+            double low = std::ceil(range.low);
+            double high = std::floor(range.high);
+
+            if (!(low <= high) || low >= LIMIT || high < -LIMIT) {
+                return { 0, 0, true };
+            }
+
+            return {
+                low < -LIMIT ? std::numeric_limits<std::int64_t>::min() : (std::int64_t)low,
+                high >= LIMIT ? std::numeric_limits<std::int64_t>::max() : (std::int64_t)high,
+                false
+            };
+        }
+
+        template<typename T>
+        void scalarKernel(const T *pos, const T *end, const Bounds<T> &bounds, Partial<T> &partial) {
+            for (; pos != end; ++pos) {
+                if (bounds.contains(*pos)) {
+                    partial.add(*pos);
+                }
+            }
+        }
+
+#if defined(AGGREGATE_AVX2)
+        bool hasAvx2() {
+            static const bool supported = __builtin_cpu_supports("avx2");
+            return supported;
+        }
+
+        __attribute__((target("avx2")))
+        std::int64_t laneSum(__m256i lanes) {
+            alignas(32) std::int64_t values[4];
+            _mm256_store_si256((__m256i *)values, lanes);
+
+            return values[0] + values[1] + values[2] + values[3];
+        }
+
+        /**
+         * Sums the upper and lower 32 bits of the integers apart, in 64-bit
+         * lanes that can not overflow, and counts the negative ones to
+         * take 2^64 off for each of them
+         * */
+        __attribute__((target("avx2")))
+        const std::int64_t *avx2Kernel(const std::int64_t *pos, const std::int64_t *end, const Bounds<std::int64_t> &bounds, Partial<std::int64_t> &partial) {
+            // the upper halves are below 2^32, so lanes hold 2^31 of them
+            constexpr std::size_t BLOCK = std::size_t(1) << 32;
+
+            const __m256i low = _mm256_set1_epi64x(bounds.low);
+            const __m256i high = _mm256_set1_epi64x(bounds.high);
+            const __m256i zero = _mm256_setzero_si256();
+            const __m256i lowerHalf = _mm256_set1_epi64x(0xFFFFFFFF);
+
+            __m256i minimum = _mm256_set1_epi64x(std::numeric_limits<std::int64_t>::max());
+            __m256i maximum = _mm256_set1_epi64x(std::numeric_limits<std::int64_t>::min());
+            __m256i counts = zero;
+
+            while (end - pos >= 4) {
+                const std::int64_t *stop = pos + std::min<std::size_t>((std::size_t)(end - pos) & ~std::size_t(3), BLOCK);
+
+                __m256i lowerSums = zero;
+                __m256i upperSums = zero;
+                __m256i negatives = zero;
+
+                for (; pos != stop; pos += 4) {
+                    __m256i values = _mm256_loadu_si256((const __m256i *)pos);
+                    __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi64(low, values), _mm256_cmpgt_epi64(values, high));
+
+                    // outside lanes count as zero
+                    __m256i kept = _mm256_andnot_si256(outside, values);
+
+                    lowerSums = _mm256_add_epi64(lowerSums, _mm256_and_si256(kept, lowerHalf));
+                    upperSums = _mm256_add_epi64(upperSums, _mm256_srli_epi64(kept, 32));
+                    negatives = _mm256_sub_epi64(negatives, _mm256_cmpgt_epi64(zero, kept));
+                    counts = _mm256_sub_epi64(counts, _mm256_andnot_si256(outside, _mm256_cmpeq_epi64(zero, zero)));
+
+                    minimum = _mm256_blendv_epi8(minimum, values, _mm256_andnot_si256(outside, _mm256_cmpgt_epi64(minimum, values)));
+                    maximum = _mm256_blendv_epi8(maximum, values, _mm256_andnot_si256(outside, _mm256_cmpgt_epi64(values, maximum)));
+                }
+
+                partial.sum += ((Wide)(std::uint64_t)laneSum(upperSums) << 32) + (Wide)(std::uint64_t)laneSum(lowerSums) - ((Wide)laneSum(negatives) << 64);
+            }
+
+            alignas(32) std::int64_t minimums[4];
+            alignas(32) std::int64_t maximums[4];
+            _mm256_store_si256((__m256i *)minimums, minimum);
+            _mm256_store_si256((__m256i *)maximums, maximum);
+
+            partial.count += (std::size_t)laneSum(counts);
+            partial.min = std::min({ partial.min, minimums[0], minimums[1], minimums[2], minimums[3] });
+            partial.max = std::max({ partial.max, maximums[0], maximums[1], maximums[2], maximums[3] });
+
+            return pos;
+        }
+
+        __attribute__((target("avx2")))
+        const double *avx2Kernel(const double *pos, const double *end, const Bounds<double> &bounds, Partial<double> &partial) {
+            const __m256d low = _mm256_set1_pd(bounds.low);
+            const __m256d high = _mm256_set1_pd(bounds.high);
+            const __m256d infinity = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+            const __m256d negativeInfinity = _mm256_set1_pd(-std::numeric_limits<double>::infinity());
+
+            __m256d sums = _mm256_setzero_pd();
+            __m256d minimum = infinity;
+            __m256d maximum = negativeInfinity;
+            __m256i counts = _mm256_setzero_si256();
+
+            for (; end - pos >= 4; pos += 4) {
+                __m256d values = _mm256_loadu_pd(pos);
+                __m256d inside = _mm256_and_pd(_mm256_cmp_pd(values, low, _CMP_GE_OQ), _mm256_cmp_pd(values, high, _CMP_LE_OQ));
+
+                sums = _mm256_add_pd(sums, _mm256_and_pd(inside, values));
+                counts = _mm256_sub_epi64(counts, _mm256_castpd_si256(inside));
+                minimum = _mm256_min_pd(minimum, _mm256_blendv_pd(infinity, values, inside));
+                maximum = _mm256_max_pd(maximum, _mm256_blendv_pd(negativeInfinity, values, inside));
+            }
+
+            alignas(32) double lanes[4];
+            std::size_t count = (std::size_t)laneSum(counts);
+
+            _mm256_store_pd(lanes, sums);
+            partial.sum += (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+
+            // lanes that kept nothing hold the infinities
+            if (count != 0) {
+                _mm256_store_pd(lanes, minimum);
+                partial.min = std::min({ partial.min, lanes[0], lanes[1], lanes[2], lanes[3] });
+                _mm256_store_pd(lanes, maximum);
+                partial.max = std::max({ partial.max, lanes[0], lanes[1], lanes[2], lanes[3] });
+            }
+
+            partial.count += count;
+
+            return pos;
+        }
+#endif
+
+        template<typename T>
+        Partial<T> kernel(std::span<const T> values, const Bounds<T> &bounds) {
+            Partial<T> partial;
+            const T *pos = values.data();
+            const T *end = values.data() + values.size();
+
+#if defined(AGGREGATE_AVX2)
+            if (hasAvx2()) {
+                pos = avx2Kernel(pos, end, bounds, partial);
+            }
+#endif
+
+            scalarKernel(pos, end, bounds, partial);
+
+            return partial;
+        }
+
+        // runs the kernel over slices of the input on as many threads as pay off
+        template<typename T>
+        Partial<T> reduce(std::span<const T> values, const Bounds<T> &bounds) {
+            if (bounds.empty) {
+                return Partial<T>();
+            }
+
+            std::size_t jobs = std::min<std::size_t>(std::max(std::thread::hardware_concurrency(), 1u), values.size() / PARALLEL_CHUNK);
+
+            if (jobs <= 1) {
+                return kernel(values, bounds);
+            }
+
+            std::vector<Partial<T>> partials(jobs);
+            std::vector<std::thread> threads;
+            std::size_t slice = (values.size() + jobs - 1) / jobs;
+
+            for (std::size_t job = 1; job < jobs; ++job) {
+                threads.emplace_back([&, job]() {
+                    partials[job] = kernel(values.subspan(job * slice, std::min(slice, values.size() - job * slice)), bounds);
+                });
+            }
+
+            partials[0] = kernel(values.first(slice), bounds);
+
+            for (auto &thread : threads) {
+                thread.join();
+            }
+
+            for (std::size_t job = 1; job < jobs; ++job) {
+                partials[0].merge(partials[job]);
+            }
+
+            return partials[0];
+        }
+
+        /**
+         * The integers and the decimals of a mixed input are gathered
+         * apart, each exactly as their kernel would
+         * */
+        struct Totals {
+            Bounds<std::int64_t> integerBounds;
+            Bounds<double> doubleBounds;
+
+            Partial<std::int64_t> integers;
+            Partial<double> doubles;
+
+            explicit Totals(const Range &range)
+                : integerBounds(boundsOf(range, std::int64_t())), doubleBounds(boundsOf(range, double()))
+            {
+            }
+
+            void add(std::int64_t value) {
+                if (!integerBounds.empty && integerBounds.contains(value)) {
+                    integers.add(value);
+                }
+            }
+
+            void add(double value) {
+                if (!doubleBounds.empty && doubleBounds.contains(value)) {
+                    doubles.add(value);
+                }
+            }
+
+            void add(const Number &number) {
+                if (number.getClass() == Number::Class::Int64) {
+                    add((std::int64_t)number.toInt64());
+                } else {
+                    add(number.toDouble());
+                }
+            }
+
+            void add(std::span<const std::int64_t> values) {
+                integers.merge(reduce(values, integerBounds));
+            }
+
+            void add(std::span<const double> values) {
+                doubles.merge(reduce(values, doubleBounds));
+            }
+
+            Aggregate result() const {
+                Aggregate aggregate;
+
+                aggregate.count = integers.count + doubles.count;
+                aggregate.sum = (double)integers.sum + doubles.sum;
+
+                if (integers.count != 0) {
+                    aggregate.min = (double)integers.min;
+                    aggregate.max = (double)integers.max;
+                }
+
+                if (doubles.count != 0) {
+                    aggregate.min = integers.count != 0 ? std::min(aggregate.min, doubles.min) : doubles.min;
+                    aggregate.max = integers.count != 0 ? std::max(aggregate.max, doubles.max) : doubles.max;
+                }
+
+                return aggregate;
+            }
+        };
+
+        // the numbers of the rows of a column whose bits are set
+        template<typename T>
+        void addValid(Totals &totals, std::span<const T> values, std::span<const std::uint64_t> validity) {
+            constexpr std::uint64_t ALL = ~std::uint64_t(0);
+            std::size_t word = 0;
+
+            while (word < validity.size()) {
+                std::size_t first = word;
+
+                // runs of words without nulls go to the kernel in one piece
+                while (word < validity.size() && validity[word] == ALL && (word + 1) * 64 <= values.size()) {
+                    ++word;
+                }
+
+                if (word != first) {
+                    totals.add(values.subspan(first * 64, (word - first) * 64));
+                    continue;
+                }
+
+                for (std::uint64_t bits = validity[word]; bits != 0; bits &= bits - 1) {
+                    totals.add(values[word * 64 + (std::size_t)__builtin_ctzll(bits)]);
+                }
+
+                ++word;
+            }
+        }
+
+        std::vector<std::string> parsePath(std::string_view path) {
+            std::vector<std::string> tokens;
+
+            if (!path.empty() && path.front() != '/') {
+                throw std::invalid_argument("JSON::aggregate: the path is not a JSON Pointer");
+            }
+
+            for (std::size_t i = 0; i < path.size(); ++i) {
+                char c = path[i];
+
+                if (c == '/') {
+                    tokens.emplace_back();
+                } else if (c == '~') {
+                    // "~0" is '~' and "~1" is '/'
+                    if (i + 1 == path.size() || (path[i + 1] != '0' && path[i + 1] != '1')) {
+                        throw std::invalid_argument("JSON::aggregate: the path is not a JSON Pointer");
+                    }
+
+                    tokens.back().push_back(path[++i] == '0' ? '~' : '/');
+                } else {
+                    tokens.back().push_back(c);
+                }
+            }
+
+            return tokens;
+        }
+    };
+
+    /**
+     * Walks a path through a document, fanning out over Arrays
+     * */
+    class Aggregator {
+        public:
+            static void walk(const Json &root, const std::vector<std::string> &tokens, Totals &totals);
+    };
+
+    void Aggregator::walk(const Json &root, const std::vector<std::string> &tokens, Totals &totals) {
+        // the values still to visit and how much of the path they used,
+        // kept on the heap since Arrays may nest arbitrarily deep
+        std::vector<std::pair<const Json *, std::size_t>> pending{ { &root, 0 } };
+
+        while (!pending.empty()) {
+            auto [value, depth] = pending.back();
+            pending.pop_back();
+
+            switch (value->type) {
+                case Json::Type::Integer:
+                case Json::Type::FloatingPoint: {
+                    if (depth == tokens.size()) {
+                        totals.add(value->getNumber());
+                    }
+                } break;
+
+                case Json::Type::Array: {
+                    const auto &elements = *std::get<Json::Type::Array>(value->value);
+
+                    if (elements.isPacked()) {
+                        if (depth != tokens.size()) {
+                            break;
+                        }
+
+                        if (elements.packed.index() == 1) {
+                            totals.add(std::span<const std::int64_t>(std::get<1>(elements.packed)));
+                        } else {
+                            totals.add(std::span<const double>(std::get<2>(elements.packed)));
+                        }
+
+                        break;
+                    }
+
+                    // pushed in reverse so the elements are visited in order
+                    for (auto element = elements.rbegin(); element != elements.rend(); ++element) {
+                        pending.emplace_back(&*element, depth);
+                    }
+                } break;
+
+                case Json::Type::Object: {
+                    if (depth == tokens.size()) {
+                        break;
+                    }
+
+                    const auto &members = *std::get<Json::Type::Object>(value->value);
+                    auto found = members.find(std::string_view(tokens[depth]));
+
+                    if (found != members.end()) {
+                        pending.emplace_back(&found->second, depth + 1);
+                    }
+                } break;
+
+                default: break;
+            }
+        }
+    }
+
+    Aggregate aggregate(std::span<const std::int64_t> values, const Range &range) {
+        Totals totals(range);
+        totals.add(values);
+
+        return totals.result();
+    }
+
+    Aggregate aggregate(std::span<const double> values, const Range &range) {
+        Totals totals(range);
+        totals.add(values);
+
+        return totals.result();
+    }
+
+    Aggregate aggregate(const Column &column, const Range &range) {
+        Totals totals(range);
+
+        switch (column.getKind()) {
+            case Column::Kind::Integer: {
+                addValid(totals, column.integers(), column.validityBitmap());
+            } break;
+
+            case Column::Kind::FloatingPoint: {
+                addValid(totals, column.doubles(), column.validityBitmap());
+            } break;
+
+            case Column::Kind::Value: {
+                for (const auto &value : column.values()) {
+                    if (value.isInteger() || value.isFloatingPoint()) {
+                        totals.add(value.getNumber());
+                    }
+                }
+            } break;
+
+            default: break;
+        }
+
+        return totals.result();
+    }
+
+    Aggregate aggregate(const Json &value, std::string_view path, const Range &range) {
+        Totals totals(range);
+        Aggregator::walk(value, parsePath(path), totals);
+
+        return totals.result();
+    }
+
+}; // namespace JSON
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string_view>
+
+#include "columns.hpp"
+#include "json.hpp"
+
+namespace JSON {
+
+    /**
+     * The numbers an aggregation keeps, both ends included. Filtered
+     * counts are the count of an aggregation over a Range.
+     * */
+    struct Range {
+        double low = -std::numeric_limits<double>::infinity();
+        double high = std::numeric_limits<double>::infinity();
+    };
+
+    /**
+     * The result of aggregate(). Integers are summed exactly and the
+     * sum is rounded to a double once, decimals are summed in lanes so
+     * the last bits may differ from a sequential loop.
+     * */
+    struct Aggregate {
+        std::size_t count = 0;
+        double sum = 0;
+
+        // NaN when no number was aggregated
+        double min = std::numeric_limits<double>::quiet_NaN();
+        double max = std::numeric_limits<double>::quiet_NaN();
+
+        double mean() const {
+            return count == 0 ? std::numeric_limits<double>::quiet_NaN() : sum / (double)count;
+        }
+    };
+
+    /**
+     * These functions aggregate contiguous numbers with AVX2 where the
+     * processor has it, and split inputs of millions of numbers across
+     * threads
+     * */
+    Aggregate aggregate(std::span<const std::int64_t> values, const Range &range = {});
+    Aggregate aggregate(std::span<const double> values, const Range &range = {});
+
+    /**
+     * This function aggregates the numbers of a column, skipping the
+     * rows that are null. Columns of booleans or strings have none.
+     * */
+    Aggregate aggregate(const Column &column, const Range &range = {});
+
+    /**
+     * This function aggregates the numbers a JSON Pointer leads to,
+     * where every Array on the way stands for all of its elements:
+     * "/parents/age" covers the age of each of the parents, and ""
+     * covers the numbers of the value itself or of its Arrays. Values
+     * that are not numbers are skipped.
+     *
+     *     JSON::aggregate(*json, "/orders/total", { 0, 100 }).count
+     *
+     * @throw std::invalid_argument
+     *     If path is not a JSON Pointer.
+     * */
+    Aggregate aggregate(const Json &value, std::string_view path = "", const Range &range = {});
+
+}; // namespace JSON
@@ -0,0 +1,99 @@
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+#include "arena.hpp"
+#include "memory.hpp"
+
+namespace JSON {
+
+    namespace {
+
+        char *alignUp(char *pointer, std::size_t alignment) {
+            std::uintptr_t address = (std::uintptr_t)pointer;
+            return pointer + ((alignment - address % alignment) % alignment);
+        }
+    };
+
+    Arena::Arena(std::size_t blockSize)
+        : current(0), nextSize(blockSize == 0 ? 1 : blockSize), total(0), filled(0), pos(nullptr), end(nullptr)
+    {
+    }
+
+    Arena::~Arena() {
+        for (const auto &block : blocks) {
+            ::operator delete(block.data, std::align_val_t(alignof(std::max_align_t)));
+        }
+
+        Memory::account(-(std::ptrdiff_t)total);
+    }
+
+    void Arena::reset() {
+        current = 0;
+        filled = 0;
+
+        if (blocks.empty()) {
+            return;
+        }
+
+        pos = blocks.front().data;
+        end = pos + blocks.front().size;
+    }
+
+    std::size_t Arena::used() const {
+        return blocks.empty() ? 0 : filled + (std::size_t)(pos - blocks[current].data);
+    }
+
+    void *Arena::do_allocate(std::size_t bytes, std::size_t alignment) {
+        char *aligned = (pos == nullptr) ? nullptr : alignUp(pos, alignment);
+
+        if (aligned == nullptr || bytes > (std::size_t)(end - aligned)) {
+            // enough for the padding of any alignment
+            advance(bytes + alignment);
+            aligned = alignUp(pos, alignment);
+        }
+
+        pos = aligned + bytes;
+
+        return aligned;
+    }
+
+    void Arena::do_deallocate(void *, std::size_t, std::size_t) {
+        // everything is freed at once by reset()
+    }
+
+    bool Arena::do_is_equal(const std::pmr::memory_resource &other) const noexcept {
+        return this == &other;
+    }
+
+    void Arena::advance(std::size_t size) {
+        if (!blocks.empty()) {
+            filled += (std::size_t)(end - blocks[current].data);
+        }
+
+        // blocks kept from before the last reset come first, the ones
+        // too small for this request are left unused until then
+        std::size_t next = blocks.empty() ? 0 : current + 1;
+
+        while (next < blocks.size() && blocks[next].size < size) {
+            filled += blocks[next].size;
+            ++next;
+        }
+
+        if (next == blocks.size()) {
+            std::size_t blockSize = std::max(nextSize, size);
+            blocks.reserve(blocks.size() + 1);
+            char *data = (char *)::operator new(blockSize, std::align_val_t(alignof(std::max_align_t)));
+
+            blocks.push_back({ data, blockSize });
+            nextSize = blockSize * 2;
+            total += blockSize;
+            Memory::account((std::ptrdiff_t)blockSize);
+        }
+
+        current = next;
+        pos = blocks[current].data;
+        end = pos + blocks[current].size;
+    }
+
+}; // namespace JSON
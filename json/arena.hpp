@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+namespace JSON {
+
+    /**
+     * A memory resource that hands out memory by bumping a pointer
+     * through blocks it keeps until it is destroyed.
+     *
+     * Deallocation does nothing, reset() makes the whole arena free again
+     * in constant time without returning the blocks, so filling it with
+     * the same amount of data again allocates nothing. New blocks are
+     * twice as large as the last one, or as large as a request needs.
+     * The blocks count towards Memory::liveBytes().
+     * */
+    class Arena : public std::pmr::memory_resource {
+        public:
+            explicit Arena(std::size_t blockSize = 64 * 1024);
+            ~Arena();
+
+            Arena(const Arena &other) = delete;
+            Arena &operator=(const Arena &other) = delete;
+
+            /**
+             * This method frees everything allocated so far. Objects in
+             * the arena are not destroyed, so nothing may own memory
+             * outside of it or be used again.
+             * */
+            void reset();
+
+            // the bytes handed out since the last reset, with padding and
+            // the ends of blocks that were too small to go on with
+            std::size_t used() const;
+
+            // the bytes of all blocks
+            std::size_t capacity() const { return total; }
+
+        protected:
+            void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+            void do_deallocate(void *pointer, std::size_t bytes, std::size_t alignment) override;
+            bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+        private:
+            struct Block {
+                char *data;
+                std::size_t size;
+            };
+
+            // moves on to a block of at least size bytes, kept or new
+            void advance(std::size_t size);
+
+        private:
+            std::vector<Block> blocks;
+            std::size_t current;
+            std::size_t nextSize;
+            std::size_t total;
+
+            // used bytes of the blocks before the current one
+            std::size_t filled;
+
+            char *pos;
+            char *end;
+    };
+
+}; // namespace JSON
@@ -0,0 +1,378 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "json.hpp"
+#include "scanner.hpp"
+
+namespace JSON {
+
+    namespace {
+
+        // one tag byte precedes every encoded value
+        enum Tag : unsigned char {
+            TagInvalid = 0,
+            TagNull,
+            TagFalse,
+            TagTrue,
+            TagInteger,
+            TagFloatingPoint,
+            TagString,
+            TagArray,
+            TagObject,
+            TagUnsignedInteger,
+            TagNumberText,      // the digits of a number that is kept exactly
+            TagPackedIntegers,  // a count and then 8 bytes per number
+            TagPackedDoubles
+        };
+
+
+        void writeVarint(std::string &output, unsigned long long n) {
+            while (n >= 0x80) {
+                output.push_back((char)((n & 0x7F) | 0x80));
+                n >>= 7;
+            }
+
+            output.push_back((char)n);
+        }
+
+        bool readVarint(const char *&pos, const char *end, unsigned long long &n) {
+            n = 0;
+
+            for (int shift = 0; shift < 64; shift += 7) {
+                if (pos == end) {
+                    return false;
+                }
+
+                unsigned char byte = (unsigned char)*pos++;
+                n |= (unsigned long long)(byte & 0x7F) << shift;
+
+                if (!(byte & 0x80)) {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        void writeBytes(std::string &output, std::string_view bytes) {
+            writeVarint(output, bytes.size());
+            output.append(bytes);
+        }
+
+        bool readBytes(const char *&pos, const char *end, std::string_view &bytes) {
+            unsigned long long length = 0;
+
+            if (!readVarint(pos, end, length) || length > (unsigned long long)(end - pos)) {
+                return false;
+            }
+
+            bytes = std::string_view(pos, (std::size_t)length);
+            pos += length;
+
+            return true;
+        }
+
+        template<typename T>
+        void writePacked(std::string &output, const std::pmr::vector<T> &numbers) {
+            writeVarint(output, numbers.size());
+            output.append((const char *)numbers.data(), numbers.size() * sizeof(T));
+        }
+
+        template<typename T>
+        bool readPacked(const char *&pos, const char *end, std::pmr::vector<T> &numbers) {
+            unsigned long long count = 0;
+
+            if (!readVarint(pos, end, count) || count > (unsigned long long)(end - pos) / sizeof(T)) {
+                return false;
+            }
+
+            numbers.resize((std::size_t)count);
+            std::memcpy(numbers.data(), pos, (std::size_t)count * sizeof(T));
+            pos += count * sizeof(T);
+
+            return true;
+        }
+    };
+
+    std::string Json::toBinary() const {
+        std::string output;
+        encodeBinary(output);
+
+        return output;
+    }
+
+    Json *Json::fromBinary(const char *data, std::size_t size) {
+        const char *pos = data;
+        const char *end = data + size;
+        Json *json = new Json();
+
+        // trailing bytes mean the input was not produced by toBinary()
+        if (!decodeBinary(pos, end, json) || pos != end) {
+            delete json;
+            json = new Json();
+        }
+
+        return json;
+    }
+
+    void Json::encodeBinary(std::string &output) const {
+        switch (type) {
+            case Type::Invalid: {
+                output.push_back(TagInvalid);
+            } break;
+
+            case Type::Null: {
+                output.push_back(TagNull);
+            } break;
+
+            case Type::Boolean: {
+                output.push_back(std::get<Type::Boolean>(value) ? TagTrue : TagFalse);
+            } break;
+
+            case Type::Integer: {
+                const Number &number = std::get<Type::Integer>(value);
+
+                if (number.getClass() == Number::Class::Big) {
+                    output.push_back(TagNumberText);
+                    writeBytes(output, number.text());
+                } else if (number.getClass() == Number::Class::UInt64) {
+                    output.push_back(TagUnsignedInteger);
+                    writeVarint(output, number.toUInt64());
+                } else {
+                    // zig-zag so small negative numbers stay small
+                    long long n = number.toInt64();
+                    output.push_back(TagInteger);
+                    writeVarint(output, ((unsigned long long)n << 1) ^ (unsigned long long)(n >> 63));
+                }
+            } break;
+
+            case Type::FloatingPoint: {
+                const Number &number = std::get<Type::FloatingPoint>(value);
+
+                // parsed digits stay lazy and exact
+                if (!number.text().empty()) {
+                    output.push_back(TagNumberText);
+                    writeBytes(output, number.text());
+                    break;
+                }
+
+                long double n = number.toLongDouble();
+                char raw[sizeof(long double)];
+                std::memcpy(raw, &n, sizeof(raw));
+                output.push_back(TagFloatingPoint);
+                output.append(raw, sizeof(raw));
+            } break;
+
+            case Type::String: {
+                output.push_back(TagString);
+                writeBytes(output, *(std::get<Type::String>(value)));
+            } break;
+
+            case Type::Array: {
+                const auto &elements = *(std::get<Type::Array>(value));
+
+                // packed numbers are copied as they are
+                if (const auto *integers = std::get_if<Elements::Integers>(&elements.packed)) {
+                    output.push_back(TagPackedIntegers);
+                    writePacked(output, *integers);
+                    break;
+                }
+
+                if (const auto *doubles = std::get_if<Elements::Doubles>(&elements.packed)) {
+                    output.push_back(TagPackedDoubles);
+                    writePacked(output, *doubles);
+                    break;
+                }
+
+                output.push_back(TagArray);
+                writeVarint(output, elements.size());
+
+                for (const auto &element : elements) {
+                    element.encodeBinary(output);
+                }
+            } break;
+
+            case Type::Object: {
+                const auto &members = *(std::get<Type::Object>(value));
+                output.push_back(TagObject);
+                writeVarint(output, members.size());
+
+                for (const auto &member : members) {
+                    writeBytes(output, member.first);
+                    member.second.encodeBinary(output);
+                }
+            } break;
+        }
+    }
+
+    bool Json::decodeBinary(const char *&pos, const char *end, Json *json) {
+        if (pos == end) {
+            return false;
+        }
+
+        switch ((unsigned char)*pos++) {
+            case TagInvalid: {
+                json->type = Type::Invalid;
+            } break;
+
+            case TagNull: {
+                json->type = Type::Null;
+            } break;
+
+            case TagFalse:
+            case TagTrue: {
+                json->type = Type::Boolean;
+                json->value = ((unsigned char)pos[-1] == TagTrue);
+            } break;
+
+            case TagInteger: {
+                unsigned long long n = 0;
+
+                if (!readVarint(pos, end, n)) {
+                    return false;
+                }
+
+                json->type = Type::Integer;
+                json->value.emplace<Type::Integer>((long long)((n >> 1) ^ (~(n & 1) + 1)));
+            } break;
+
+            case TagUnsignedInteger: {
+                unsigned long long n = 0;
+
+                if (!readVarint(pos, end, n)) {
+                    return false;
+                }
+
+                json->type = Type::Integer;
+                json->value.emplace<Type::Integer>(n);
+            } break;
+
+            case TagNumberText: {
+                std::string_view text;
+                const char *error = nullptr;
+
+                if (!readBytes(pos, end, text) || text.empty() ||
+                    Scanner::validateNumber(text.data(), text.data() + text.size(), error) != text.data() + text.size()) {
+                    return false;
+                }
+
+                Number number(text, nullptr);
+
+                if (number.isIntegral()) {
+                    json->type = Type::Integer;
+                    json->value.emplace<Type::Integer>(std::move(number));
+                } else {
+                    json->type = Type::FloatingPoint;
+                    json->value.emplace<Type::FloatingPoint>(std::move(number));
+                }
+            } break;
+
+            case TagFloatingPoint: {
+                long double n;
+
+                if ((std::size_t)(end - pos) < sizeof(n)) {
+                    return false;
+                }
+
+                std::memcpy(&n, pos, sizeof(n));
+                pos += sizeof(n);
+                json->type = Type::FloatingPoint;
+                json->value.emplace<Type::FloatingPoint>(n);
+            } break;
+
+            case TagString: {
+                std::string_view string;
+
+                if (!readBytes(pos, end, string)) {
+                    return false;
+                }
+
+                json->type = Type::String;
+                json->value = allocate<Text>(nullptr, string);
+            } break;
+
+            case TagArray: {
+                unsigned long long count = 0;
+
+                // every element takes at least one byte
+                if (!readVarint(pos, end, count) || count > (unsigned long long)(end - pos)) {
+                    return false;
+                }
+
+                auto elements = allocate<Elements>(nullptr, (std::size_t)count);
+                json->type = Type::Array;
+                json->value = elements;
+
+                for (auto &element : *elements) {
+                    if (!decodeBinary(pos, end, &element)) {
+                        return false;
+                    }
+                }
+            } break;
+
+            case TagPackedIntegers: {
+                auto elements = allocate<Elements>(nullptr);
+                Elements::Integers integers(elements->get_allocator());
+
+                if (!readPacked(pos, end, integers)) {
+                    return false;
+                }
+
+                if (!integers.empty()) {
+                    elements->packed = std::move(integers);
+                }
+                json->type = Type::Array;
+                json->value = elements;
+            } break;
+
+            case TagPackedDoubles: {
+                auto elements = allocate<Elements>(nullptr);
+                Elements::Doubles doubles(elements->get_allocator());
+
+                if (!readPacked(pos, end, doubles) || !std::all_of(doubles.begin(), doubles.end(), [](double d) { return std::isfinite(d); })) {
+                    return false;
+                }
+
+                if (!doubles.empty()) {
+                    elements->packed = std::move(doubles);
+                }
+                json->type = Type::Array;
+                json->value = elements;
+            } break;
+
+            case TagObject: {
+                unsigned long long count = 0;
+
+                if (!readVarint(pos, end, count) || count > (unsigned long long)(end - pos)) {
+                    return false;
+                }
+
+                auto members = allocate<Members>(nullptr);
+                members->reserve((std::size_t)count);
+                json->type = Type::Object;
+                json->value = members;
+                std::string_view name;
+
+                for (unsigned long long i = 0; i < count; ++i) {
+                    if (!readBytes(pos, end, name)) {
+                        return false;
+                    }
+
+                    Json &member = members->try_emplace(Text(name, members->get_allocator())).first->second;
+
+                    if (!decodeBinary(pos, end, &member)) {
+                        return false;
+                    }
+                }
+            } break;
+
+            default: {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+}; // namespace JSON
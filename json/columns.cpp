@@ -0,0 +1,531 @@
+#include <stdexcept>
+
+#include "columns.hpp"
+#include "parser.hpp"
+#include "scanner.hpp"
+
+namespace JSON {
+
+    std::span<const std::uint8_t> Column::booleans() const {
+        if (kind != Kind::Boolean) {
+            throw WrongTypeException();
+        }
+
+        return booleanValues;
+    }
+
+    std::span<const std::int64_t> Column::integers() const {
+        if (kind != Kind::Integer) {
+            throw WrongTypeException();
+        }
+
+        return integerValues;
+    }
+
+    std::span<const double> Column::doubles() const {
+        if (kind != Kind::FloatingPoint) {
+            throw WrongTypeException();
+        }
+
+        return doubleValues;
+    }
+
+    std::span<const std::uint32_t> Column::codes() const {
+        if (kind != Kind::String) {
+            throw WrongTypeException();
+        }
+
+        return stringCodes;
+    }
+
+    std::span<const Json> Column::values() const {
+        if (kind != Kind::Value) {
+            throw WrongTypeException();
+        }
+
+        return jsonValues;
+    }
+
+    Json Column::at(std::size_t row) const {
+        if (row >= rows) {
+            throw std::out_of_range("Column::at");
+        }
+
+        Json value;
+
+        if (isNull(row)) {
+            value = nullptr;
+            return value;
+        }
+
+        switch (kind) {
+            case Kind::Boolean: value = (booleanValues[row] != 0); break;
+            case Kind::Integer: value = (long long)integerValues[row]; break;
+            case Kind::FloatingPoint: value = Json::fromPacked(doubleValues[row], nullptr); break;
+            case Kind::String: value = strings[stringCodes[row]]; break;
+            case Kind::Value: value = jsonValues[row]; break;
+            default: break;
+        }
+
+        return value;
+    }
+
+    void Column::grow(bool valid) {
+        if (rows % 64 == 0) {
+            validity.push_back(0);
+        }
+
+        if (valid) {
+            validity.back() |= 1ULL << (rows % 64);
+        }
+
+        ++rows;
+    }
+
+    bool Column::become(Kind wanted) {
+        if (kind == wanted) {
+            return true;
+        }
+
+        if (kind == Kind::Value) {
+            return false;
+        }
+
+        // the rows so far are all null
+        if (kind == Kind::Null) {
+            switch (wanted) {
+                case Kind::Boolean: booleanValues.resize(rows, 0); break;
+                case Kind::Integer: integerValues.resize(rows, 0); break;
+                case Kind::FloatingPoint: doubleValues.resize(rows, 0.0); break;
+                case Kind::String: stringCodes.resize(rows, 0); break;
+
+                default: {
+                    Json null;
+                    null = nullptr;
+                    jsonValues.resize(rows, null);
+                } break;
+            }
+
+            kind = wanted;
+            return true;
+        }
+
+        if (kind == Kind::Integer && wanted == Kind::FloatingPoint) {
+            doubleValues.assign(integerValues.begin(), integerValues.end());
+            integerValues = {};
+            kind = Kind::FloatingPoint;
+
+            return true;
+        }
+
+        // kinds that do not mix turn into Json values
+        std::vector<Json> converted;
+        converted.reserve(rows);
+
+        for (std::size_t row = 0; row < rows; ++row) {
+            converted.push_back(at(row));
+        }
+
+        booleanValues = {};
+        integerValues = {};
+        doubleValues = {};
+        stringCodes = {};
+        strings = {};
+        dictionaryIndex = {};
+
+        jsonValues = std::move(converted);
+        kind = Kind::Value;
+
+        return wanted == Kind::Value;
+    }
+
+    void Column::append(const Json &value) {
+        switch (value.type) {
+            case Json::Type::Null: {
+                appendNull();
+            } return;
+
+            case Json::Type::Boolean: {
+                appendBoolean(std::get<Json::Type::Boolean>(value.value));
+            } return;
+
+            case Json::Type::Integer: {
+                const Number &number = std::get<Json::Type::Integer>(value.value);
+
+                if (number.getClass() == Number::Class::Int64) {
+                    appendInteger(number.toInt64());
+                    return;
+                }
+            } break;
+
+            case Json::Type::FloatingPoint: {
+                appendDouble(std::get<Json::Type::FloatingPoint>(value.value).toDouble());
+            } return;
+
+            case Json::Type::String: {
+                appendString(*std::get<Json::Type::String>(value.value));
+            } return;
+
+            default: break;
+        }
+
+        // Arrays, Objects and integers beyond 64 bits
+        become(Kind::Value);
+        jsonValues.push_back(value);
+        grow(true);
+    }
+
+    void Column::appendNull() {
+        switch (kind) {
+            case Kind::Boolean: booleanValues.push_back(0); break;
+            case Kind::Integer: integerValues.push_back(0); break;
+            case Kind::FloatingPoint: doubleValues.push_back(0.0); break;
+            case Kind::String: stringCodes.push_back(0); break;
+
+            case Kind::Value: {
+                jsonValues.emplace_back();
+                jsonValues.back() = nullptr;
+            } break;
+
+            default: break;
+        }
+
+        grow(false);
+    }
+
+    void Column::appendBoolean(bool boolean) {
+        if (!become(Kind::Boolean)) {
+            Json value;
+            value = boolean;
+            jsonValues.push_back(std::move(value));
+            grow(true);
+            return;
+        }
+
+        booleanValues.push_back(boolean);
+        grow(true);
+    }
+
+    void Column::appendInteger(std::int64_t integer) {
+        // integers meeting decimals are widened
+        if (kind == Kind::FloatingPoint) {
+            appendDouble((double)integer);
+            return;
+        }
+
+        if (!become(Kind::Integer)) {
+            Json value;
+            value = (long long)integer;
+            jsonValues.push_back(std::move(value));
+            grow(true);
+            return;
+        }
+
+        integerValues.push_back(integer);
+        grow(true);
+    }
+
+    void Column::appendDouble(double floatingPoint) {
+        if (!become(Kind::FloatingPoint)) {
+            jsonValues.push_back(Json::fromPacked(floatingPoint, nullptr));
+            grow(true);
+            return;
+        }
+
+        doubleValues.push_back(floatingPoint);
+        grow(true);
+    }
+
+    void Column::appendString(std::string_view string) {
+        if (!become(Kind::String)) {
+            Json value;
+            value = std::string(string);
+            jsonValues.push_back(std::move(value));
+            grow(true);
+            return;
+        }
+
+        auto found = dictionaryIndex.find(string);
+        std::uint32_t code = 0;
+
+        if (found != dictionaryIndex.end()) {
+            code = found->second;
+        } else {
+            code = (std::uint32_t)strings.size();
+            strings.emplace_back(string);
+            dictionaryIndex.emplace(strings.back(), code);
+        }
+
+        stringCodes.push_back(code);
+        grow(true);
+    }
+
+    void Column::removeLast() {
+        switch (kind) {
+            case Kind::Boolean: booleanValues.pop_back(); break;
+            case Kind::Integer: integerValues.pop_back(); break;
+            case Kind::FloatingPoint: doubleValues.pop_back(); break;
+            case Kind::String: stringCodes.pop_back(); break;
+            case Kind::Value: jsonValues.pop_back(); break;
+            default: break;
+        }
+
+        --rows;
+        validity.back() &= ~(1ULL << (rows % 64));
+
+        if (rows % 64 == 0) {
+            validity.pop_back();
+        }
+    }
+
+
+    bool Table::contains(std::string_view name) const {
+        return index.find(name) != index.end();
+    }
+
+    const Column &Table::column(std::string_view name) const {
+        auto found = index.find(name);
+
+        if (found == index.end()) {
+            throw std::out_of_range("Table::column: no such column");
+        }
+
+        return columns[found->second];
+    }
+
+    Column &Table::cell(std::string_view name) {
+        auto found = index.find(name);
+
+        if (found == index.end()) {
+            columns.emplace_back();
+            columnNames.emplace_back(name);
+            found = index.emplace(columnNames.back(), columns.size() - 1).first;
+
+            for (std::size_t row = 0; row < rowCount; ++row) {
+                columns.back().appendNull();
+            }
+        }
+
+        Column &column = columns[found->second];
+
+        // the last of duplicate names wins, like in Objects
+        if (column.size() > rowCount) {
+            column.removeLast();
+        }
+
+        return column;
+    }
+
+    void Table::endRow() {
+        ++rowCount;
+
+        for (auto &column : columns) {
+            if (column.size() < rowCount) {
+                column.appendNull();
+            }
+        }
+    }
+
+    void Table::finish() {
+        for (auto &column : columns) {
+            column.dictionaryIndex = {};
+        }
+    }
+
+    Table Table::fromJson(const Json &records) {
+        if (records.type != Json::Type::Array) {
+            throw WrongTypeException();
+        }
+
+        const auto &elements = *std::get<Json::Type::Array>(records.value);
+
+        // packed numbers are never records
+        if (elements.isPacked()) {
+            throw WrongTypeException();
+        }
+
+        Table table;
+
+        for (const auto &record : elements) {
+            if (record.type != Json::Type::Object) {
+                throw WrongTypeException();
+            }
+
+            for (const auto &member : *std::get<Json::Type::Object>(record.value)) {
+                table.cell(member.first).append(member.second);
+            }
+
+            table.endRow();
+        }
+
+        table.finish();
+
+        return table;
+    }
+
+    bool Table::fromText(std::string_view text, Table &table) {
+        const char *pos = text.data();
+        const char *end = text.data() + text.size();
+
+        Parser parser;
+        std::string key;
+        std::string string;
+
+        table = Table();
+        pos = Scanner::skipWhitespace(pos, end);
+
+        if (pos == end || *pos != '[') {
+            return false;
+        }
+
+        pos = Scanner::skipWhitespace(pos + 1, end);
+        bool empty = (pos != end && *pos == ']');
+
+        if (empty) {
+            ++pos;
+        }
+
+        while (!empty) {
+            if ((pos = table.readRecord(pos, end, parser, key, string)) == nullptr) {
+                table = Table();
+                return false;
+            }
+
+            pos = Scanner::skipWhitespace(pos, end);
+
+            if (pos != end && *pos == ']') {
+                ++pos;
+                break;
+            }
+
+            if (pos == end || *pos != ',') {
+                table = Table();
+                return false;
+            }
+
+            pos = Scanner::skipWhitespace(pos + 1, end);
+        }
+
+        if (Scanner::skipWhitespace(pos, end) != end) {
+            table = Table();
+            return false;
+        }
+
+        table.finish();
+
+        return true;
+    }
+
+    const char *Table::readRecord(const char *pos, const char *end, Parser &parser, std::string &key, std::string &string) {
+        const char *error = nullptr;
+
+        if (pos == end || *pos != '{') {
+            return nullptr;
+        }
+
+        pos = Scanner::skipWhitespace(pos + 1, end);
+
+        if (pos != end && *pos == '}') {
+            endRow();
+            return pos + 1;
+        }
+
+        while (true) {
+            key.clear();
+
+            if (pos == end || *pos != '"' || (pos = Scanner::decodeString(pos, end, key, error)) == nullptr) {
+                return nullptr;
+            }
+
+            pos = Scanner::skipWhitespace(pos, end);
+
+            if (pos == end || *pos != ':') {
+                return nullptr;
+            }
+
+            pos = Scanner::skipWhitespace(pos + 1, end);
+
+            if (pos == end) {
+                return nullptr;
+            }
+
+            Column &column = cell(key);
+            const char *stop = nullptr;
+
+            switch (*pos) {
+                case '"': {
+                    string.clear();
+
+                    if ((stop = Scanner::decodeString(pos, end, string, error)) != nullptr) {
+                        column.appendString(string);
+                    }
+                } break;
+
+                case 't':
+                case 'f': {
+                    bool boolean = (*pos == 't');
+
+                    if ((stop = Scanner::validateLiteral(pos, end, boolean ? "true" : "false", boolean ? 4 : 5, error)) != nullptr) {
+                        column.appendBoolean(boolean);
+                    }
+                } break;
+
+                case 'n': {
+                    if ((stop = Scanner::validateLiteral(pos, end, "null", 4, error)) != nullptr) {
+                        column.appendNull();
+                    }
+                } break;
+
+                // nested values are the only ones parsed into Json
+                case '[':
+                case '{': {
+                    Json value;
+                    stop = Scanner::skipValue(pos, end);
+
+                    if (stop == nullptr || !parser.parse(pos, (std::size_t)(stop - pos), value)) {
+                        return nullptr;
+                    }
+
+                    column.append(value);
+                } break;
+
+                default: {
+                    if ((stop = Scanner::validateNumber(pos, end, error)) == nullptr) {
+                        return nullptr;
+                    }
+
+                    Number number(std::string_view(pos, (std::size_t)(stop - pos)), nullptr);
+
+                    if (number.getClass() == Number::Class::Int64) {
+                        column.appendInteger(number.toInt64());
+                    } else if (number.getClass() == Number::Class::Double) {
+                        column.appendDouble(number.toDouble());
+                    } else {
+                        Json value;
+                        value.type = Json::Type::Integer;
+                        value.value.emplace<Json::Type::Integer>(std::move(number));
+                        column.append(value);
+                    }
+                } break;
+            }
+
+            if (stop == nullptr) {
+                return nullptr;
+            }
+
+            pos = Scanner::skipWhitespace(stop, end);
+
+            if (pos != end && *pos == '}') {
+                endRow();
+                return pos + 1;
+            }
+
+            if (pos == end || *pos != ',') {
+                return nullptr;
+            }
+
+            pos = Scanner::skipWhitespace(pos + 1, end);
+        }
+    }
+
+}; // namespace JSON
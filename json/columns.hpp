@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "json.hpp"
+
+namespace JSON {
+
+    class Parser;
+
+    /**
+     * One field of every record of a Table, stored contiguously.
+     *
+     * The kind of a column follows its values: integers that fit a long
+     * long, decimals, booleans or strings are stored in a typed vector,
+     * integers meeting decimals are widened to doubles, and any other mix
+     * falls back to a vector of Json values. Strings are dictionary
+     * encoded. Rows where the field is null or missing are cleared in
+     * the validity bitmap and hold a zero in the typed vector.
+     * */
+    class Column {
+        friend class Table;
+
+        public:
+            enum Kind : std::uint8_t {
+                Null,           // no row has a value yet
+                Boolean,
+                Integer,
+                FloatingPoint,
+                String,
+                Value           // anything else, kept as Json values
+            };
+
+            Kind getKind() const { return kind; }
+            std::size_t size() const { return rows; }
+
+            bool isNull(std::size_t row) const {
+                return !((validity[row / 64] >> (row % 64)) & 1);
+            }
+
+            // bit row % 64 of word row / 64 is set for rows with a value
+            std::span<const std::uint64_t> validityBitmap() const { return validity; }
+
+            /**
+             * These methods return the typed values of the column, one
+             * per row
+             *
+             * @throw WrongTypeException
+             *     If the column is of another kind.
+             * */
+            std::span<const std::uint8_t> booleans() const;
+            std::span<const std::int64_t> integers() const;
+            std::span<const double> doubles() const;
+            std::span<const std::uint32_t> codes() const;
+            std::span<const Json> values() const;
+
+            // the distinct strings of a String column, indexed by codes()
+            const std::vector<std::string> &dictionary() const { return strings; }
+
+            // the value of one row in any kind of column, Null if missing
+            Json at(std::size_t row) const;
+
+        private:
+            void append(const Json &value);
+            void appendNull();
+            void appendBoolean(bool boolean);
+            void appendInteger(std::int64_t integer);
+            void appendDouble(double floatingPoint);
+            void appendString(std::string_view string);
+
+            // removes the last row, for names repeated in one record
+            void removeLast();
+
+            // makes the column hold values of a kind, false if it can not
+            bool become(Kind wanted);
+
+            // adds a row to the validity bitmap
+            void grow(bool valid);
+
+        private:
+            Kind kind = Kind::Null;
+            std::size_t rows = 0;
+            std::vector<std::uint64_t> validity;
+
+            std::vector<std::uint8_t> booleanValues;
+            std::vector<std::int64_t> integerValues;
+            std::vector<double> doubleValues;
+            std::vector<std::uint32_t> stringCodes;
+            std::vector<Json> jsonValues;
+
+            std::vector<std::string> strings;
+            std::unordered_map<std::string, std::uint32_t, KeyHash, KeyEqual> dictionaryIndex;
+    };
+
+
+    /**
+     * An Array of Objects turned into one Column per member name.
+     *
+     * Scans and filters over a few fields then read only their columns,
+     * in order, instead of looking the names up in every record.
+     * */
+    class Table {
+        public:
+            std::size_t rows() const { return rowCount; }
+
+            // the member names in the order they first appear
+            const std::vector<std::string> &names() const { return columnNames; }
+
+            bool contains(std::string_view name) const;
+
+            /**
+             * @throw std::out_of_range
+             *     If no record has a member of that name.
+             * */
+            const Column &column(std::string_view name) const;
+
+            /**
+             * This method builds a Table from a parsed Array of Objects,
+             * nested Arrays and Objects go to Value columns
+             *
+             * @throw WrongTypeException
+             *     If records is not an Array or an element is not an Object.
+             * */
+            static Table fromJson(const Json &records);
+
+            /**
+             * This method builds a Table straight from JSON text holding
+             * an Array of Objects, only nested Arrays and Objects become
+             * Json values on the way
+             *
+             * @param[out] table
+             *     The Table, left empty when the text is rejected.
+             *
+             * @return
+             *     false if the text is malformed or not an Array of Objects
+             * */
+            static bool fromText(std::string_view text, Table &table);
+
+        private:
+            // the column of a name, created with nulls for earlier rows,
+            // with the value of the current row removed if it has one
+            Column &cell(std::string_view name);
+
+            // pads the columns the record had no member for
+            void endRow();
+
+            const char *readRecord(const char *pos, const char *end, Parser &parser, std::string &key, std::string &string);
+
+            // drops what was only needed while building
+            void finish();
+
+        private:
+            std::size_t rowCount = 0;
+            std::vector<std::string> columnNames;
+            std::vector<Column> columns;
+            std::unordered_map<std::string, std::size_t, KeyHash, KeyEqual> index;
+    };
+
+}; // namespace JSON
@@ -0,0 +1,435 @@
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#if defined(JSON_HAVE_ZLIB)
+#include <zlib.h>
+#endif
+
+#if defined(JSON_HAVE_ZSTD)
+#include <zstd.h>
+#endif
+
+#include "decompress.hpp"
+
+namespace JSON {
+
+    namespace {
+
+        // enough of a file to tell its codec
+        constexpr std::size_t MAGIC_SIZE = 4;
+
+        /**
+         * Turns compressed input into output a buffer at a time, keeping
+         * what does not fit the output for the next call
+         * */
+        class Decoder {
+            public:
+                virtual ~Decoder() = default;
+
+                /**
+                 * Decodes from input into output, moving both past what
+                 * was consumed and produced
+                 *
+                 * @return
+                 *     false if the input is malformed
+                 * */
+                virtual bool decode(const char *&input, const char *inputEnd, char *&output, char *outputEnd) = 0;
+
+                // whether the input so far ends where a member or frame does
+                virtual bool complete() const = 0;
+        };
+
+        class PlainDecoder : public Decoder {
+            public:
+                bool decode(const char *&input, const char *inputEnd, char *&output, char *outputEnd) override {
+                    std::size_t size = std::min((std::size_t)(inputEnd - input), (std::size_t)(outputEnd - output));
+
+                    std::memcpy(output, input, size);
+                    input += size;
+                    output += size;
+
+                    return true;
+                }
+
+                bool complete() const override { return true; }
+        };
+
+#if defined(JSON_HAVE_ZLIB)
+        class GzipDecoder : public Decoder {
+            public:
+                GzipDecoder() : stream(), inMember(false) {
+                    // 16 makes zlib expect the gzip wrapper
+                    if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) {
+                        throw std::bad_alloc();
+                    }
+                }
+
+                ~GzipDecoder() override {
+                    inflateEnd(&stream);
+                }
+
+                bool decode(const char *&input, const char *inputEnd, char *&output, char *outputEnd) override {
+                    while (output != outputEnd) {
+                        stream.next_in = (Bytef *)input;
+                        stream.avail_in = (uInt)std::min<std::size_t>((std::size_t)(inputEnd - input), 1u << 30);
+                        stream.next_out = (Bytef *)output;
+                        stream.avail_out = (uInt)std::min<std::size_t>((std::size_t)(outputEnd - output), 1u << 30);
+
+                        int status = inflate(&stream, Z_NO_FLUSH);
+                        bool progress = ((const char *)stream.next_in != input || (char *)stream.next_out != output);
+
+                        input = (const char *)stream.next_in;
+                        output = (char *)stream.next_out;
+
+                        if (status == Z_STREAM_END) {
+                            // another member may follow
+                            inflateReset(&stream);
+                            inMember = false;
+                            continue;
+                        }
+
+                        if (status != Z_OK && status != Z_BUF_ERROR) {
+                            return false;
+                        }
+
+                        inMember = inMember || progress;
+
+                        if (!progress) {
+                            break;
+                        }
+                    }
+
+                    return true;
+                }
+
+                bool complete() const override { return !inMember; }
+
+            private:
+                z_stream stream;
+                bool inMember;
+        };
+#endif
+
+#if defined(JSON_HAVE_ZSTD)
+        class ZstdDecoder : public Decoder {
+            public:
+                ZstdDecoder() : context(ZSTD_createDCtx()), pending(0) {
+                    if (context == nullptr) {
+                        throw std::bad_alloc();
+                    }
+                }
+
+                ~ZstdDecoder() override {
+                    ZSTD_freeDCtx(context);
+                }
+
+                bool decode(const char *&input, const char *inputEnd, char *&output, char *outputEnd) override {
+                    while (output != outputEnd) {
+                        ZSTD_inBuffer in{ input, (std::size_t)(inputEnd - input), 0 };
+                        ZSTD_outBuffer out{ output, (std::size_t)(outputEnd - output), 0 };
+
+                        // the hint is 0 once a frame is complete
+                        std::size_t hint = ZSTD_decompressStream(context, &out, &in);
+
+                        if (ZSTD_isError(hint)) {
+                            return false;
+                        }
+
+                        // a call without progress hints at the next frame
+                        if (in.pos == 0 && out.pos == 0) {
+                            break;
+                        }
+
+                        input += in.pos;
+                        output += out.pos;
+                        pending = hint;
+                    }
+
+                    return true;
+                }
+
+                bool complete() const override { return pending == 0; }
+
+            private:
+                ZSTD_DCtx *context;
+                std::size_t pending;
+        };
+#endif
+
+        std::unique_ptr<Decoder> makeDecoder(Codec codec) {
+            switch (codec) {
+#if defined(JSON_HAVE_ZLIB)
+                case Codec::Gzip: return std::make_unique<GzipDecoder>();
+#endif
+#if defined(JSON_HAVE_ZSTD)
+                case Codec::Zstd: return std::make_unique<ZstdDecoder>();
+#endif
+                case Codec::Plain: return std::make_unique<PlainDecoder>();
+                default: return nullptr;
+            }
+        }
+
+        /**
+         * A decompressing thread and the ring of chunks it fills, the
+         * reader takes the chunks in order and hands each one back once
+         * it has copied all of it out
+         * */
+        class Pipeline {
+            public:
+                Pipeline(ChunkReader source, std::size_t chunkSize, std::size_t chunks)
+                    : source(std::move(source)), chunkSize(std::max<std::size_t>(chunkSize, 1)), ring(std::max<std::size_t>(chunks, 2)),
+                      head(0), filled(0), offset(0), ended(false), failed(false), cancelled(false)
+                {
+                    for (auto &chunk : ring) {
+                        chunk.data.resize(this->chunkSize);
+                    }
+
+                    producer = std::thread([this]() { run(); });
+                }
+
+                ~Pipeline() {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        cancelled = true;
+                    }
+
+                    freed.notify_all();
+                    producer.join();
+                }
+
+                std::size_t read(char *buffer, std::size_t capacity) {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    ready.wait(lock, [this]() { return filled != 0 || ended; });
+
+                    if (filled == 0) {
+                        return failed ? READ_FAILED : 0;
+                    }
+
+                    // the producer leaves filled chunks alone
+                    Chunk &chunk = ring[head];
+                    std::size_t size = std::min(capacity, chunk.size - offset);
+
+                    lock.unlock();
+                    std::memcpy(buffer, chunk.data.data() + offset, size);
+                    lock.lock();
+
+                    offset += size;
+
+                    if (offset == chunk.size) {
+                        head = (head + 1) % ring.size();
+                        offset = 0;
+                        --filled;
+                        freed.notify_one();
+                    }
+
+                    return size;
+                }
+
+            private:
+                struct Chunk {
+                    std::string data;
+                    std::size_t size = 0;
+                };
+
+                void run() {
+                    bool succeeded = false;
+
+                    try {
+                        succeeded = produce();
+                    } catch (...) {
+                        // a failing source is reported like malformed input
+                    }
+
+                    std::lock_guard<std::mutex> lock(mutex);
+                    ended = true;
+                    failed = !succeeded;
+                    ready.notify_one();
+                }
+
+                /**
+                 * Decompresses the source into the ring until it runs out
+                 *
+                 * @return
+                 *     false if the input is malformed, cut short, followed
+                 *     by anything but more members or frames, or of a codec
+                 *     this build does not support
+                 * */
+                bool produce() {
+                    std::string input(std::max(chunkSize, MAGIC_SIZE), '\0');
+                    std::size_t size = 0;
+                    bool exhausted = false;
+
+                    while (size < MAGIC_SIZE && !exhausted) {
+                        std::size_t read = source(input.data() + size, input.size() - size);
+                        exhausted = (read == 0);
+                        size += read;
+                    }
+
+                    Codec codec = detectCodec(std::string_view(input.data(), size));
+
+                    if (!isSupported(codec)) {
+                        return false;
+                    }
+
+                    std::unique_ptr<Decoder> decoder = makeDecoder(codec);
+                    const char *pos = input.data();
+                    const char *end = input.data() + size;
+                    bool done = false;
+                    bool valid = true;
+
+                    while (!done) {
+                        Chunk *chunk = nullptr;
+
+                        {
+                            std::unique_lock<std::mutex> lock(mutex);
+                            freed.wait(lock, [this]() { return filled < ring.size() || cancelled; });
+
+                            if (cancelled) {
+                                return true;
+                            }
+
+                            chunk = &ring[(head + filled) % ring.size()];
+                        }
+
+                        char *out = chunk->data.data();
+                        char *outEnd = out + chunkSize;
+
+                        while (out != outEnd) {
+                            if (pos == end && !exhausted) {
+                                std::size_t read = source(input.data(), input.size());
+                                exhausted = (read == 0);
+                                pos = input.data();
+                                end = input.data() + read;
+                            }
+
+                            const char *consumed = pos;
+                            char *produced = out;
+
+                            if (!decoder->decode(pos, end, out, outEnd)) {
+                                valid = false;
+                                done = true;
+                                break;
+                            }
+
+                            // nothing more to decode, or nothing it can decode,
+                            // which is only right at the end of the last frame
+                            if (pos == consumed && out == produced && (exhausted || pos != end)) {
+                                valid = exhausted && pos == end && decoder->complete();
+                                done = true;
+                                break;
+                            }
+                        }
+
+                        std::lock_guard<std::mutex> lock(mutex);
+                        chunk->size = (std::size_t)(out - chunk->data.data());
+
+                        if (chunk->size != 0) {
+                            ++filled;
+                            ready.notify_one();
+                        }
+                    }
+
+                    return valid;
+                }
+
+            private:
+                ChunkReader source;
+                std::size_t chunkSize;
+
+                std::vector<Chunk> ring;
+                std::size_t head;       // the chunk the reader copies from
+                std::size_t filled;     // chunks from head on that hold output
+                std::size_t offset;     // bytes of the head chunk already read
+                bool ended;
+                bool failed;            // the output ended at an error
+                bool cancelled;
+
+                std::mutex mutex;
+                std::condition_variable ready;
+                std::condition_variable freed;
+
+                std::thread producer;
+        };
+    };
+
+    Codec detectCodec(std::string_view prefix) {
+        if (prefix.size() >= 2 && (unsigned char)prefix[0] == 0x1F && (unsigned char)prefix[1] == 0x8B) {
+            return Codec::Gzip;
+        }
+
+        if (prefix.size() >= 4 && prefix.substr(0, 4) == std::string_view("\x28\xB5\x2F\xFD", 4)) {
+            return Codec::Zstd;
+        }
+
+        return Codec::Plain;
+    }
+
+    bool isSupported(Codec codec) {
+        switch (codec) {
+#if defined(JSON_HAVE_ZLIB)
+            case Codec::Gzip: return true;
+#endif
+#if defined(JSON_HAVE_ZSTD)
+            case Codec::Zstd: return true;
+#endif
+            case Codec::Plain: return true;
+            default: return false;
+        }
+    }
+
+    bool decompress(std::string_view input, std::string &output) {
+        Codec codec = detectCodec(input);
+
+        if (!isSupported(codec)) {
+            return false;
+        }
+
+        std::unique_ptr<Decoder> decoder = makeDecoder(codec);
+        const char *pos = input.data();
+        const char *end = input.data() + input.size();
+        std::size_t original = output.size();
+
+        while (true) {
+            std::size_t size = output.size();
+            output.resize(size + std::max<std::size_t>(input.size(), 64 * 1024));
+
+            char *out = output.data() + size;
+            char *outEnd = output.data() + output.size();
+            bool decoded = decoder->decode(pos, end, out, outEnd);
+
+            output.resize((std::size_t)(out - output.data()));
+
+            if (!decoded) {
+                output.resize(original);
+                return false;
+            }
+
+            // room left over means the decoder has nothing more to give
+            if (out != outEnd) {
+                break;
+            }
+        }
+
+        if (pos != end || !decoder->complete()) {
+            output.resize(original);
+            return false;
+        }
+
+        return true;
+    }
+
+    ChunkReader decompressing(ChunkReader source, std::size_t chunkSize, std::size_t chunks) {
+        auto pipeline = std::make_shared<Pipeline>(std::move(source), chunkSize, chunks);
+
+        return [pipeline](char *buffer, std::size_t capacity) {
+            return pipeline->read(buffer, capacity);
+        };
+    }
+
+}; // namespace JSON
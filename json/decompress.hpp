@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include "json.hpp"
+
+namespace JSON {
+
+    enum Codec {
+        Plain,
+        Gzip,
+        Zstd
+    };
+
+    /**
+     * This function tells the codec of a file from its magic bytes,
+     * anything that is neither gzip nor zstd is Plain
+     * */
+    Codec detectCodec(std::string_view prefix);
+
+    // whether this build can decompress input of the codec
+    bool isSupported(Codec codec);
+
+    /**
+     * This function decompresses a whole buffer. Plain input is copied
+     * and concatenated gzip members or zstd frames are decompressed one
+     * after another.
+     *
+     * @param[out] output
+     *     The decompressed bytes, appended to what it holds.
+     *
+     * @return
+     *     false if the input is malformed, cut short or of a codec this
+     *     build does not support
+     * */
+    bool decompress(std::string_view input, std::string &output);
+
+    /**
+     * This function wraps a reader of compressed input in a reader of
+     * the bytes it decompresses to, detecting the codec from the first
+     * bytes read. Decompression runs ahead on a thread of its own into
+     * a ring of chunks that the returned reader takes from, so no more
+     * than chunks * chunkSize decompressed bytes are held at once
+     *
+     *     for (auto &element : JSON::elements(JSON::decompressing(reader))) { ... }
+     *
+     * The source is read on that thread only. Input that is malformed,
+     * cut short, followed by other bytes or of an unsupported codec ends
+     * the output where the error is, with a read that returns
+     * READ_FAILED, so elements() ends with an Invalid element.
+     *
+     * @param[in] chunkSize
+     *     The size of the reads from the source and of the chunks.
+     *
+     * @param[in] chunks
+     *     The number of chunks in the ring, at least 2.
+     * */
+    ChunkReader decompressing(ChunkReader source, std::size_t chunkSize = 64 * 1024, std::size_t chunks = 4);
+
+}; // namespace JSON
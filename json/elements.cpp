@@ -0,0 +1,208 @@
+#include <algorithm>
+
+#include "json.hpp"
+#include "parser.hpp"
+#include "scanner.hpp"
+
+namespace JSON {
+
+    namespace {
+
+        // a document that is in memory as a whole, there is nothing more to read
+        class TextWindow {
+            public:
+                explicit TextWindow(std::string_view text) : text(text) {}
+
+                const char *begin() const { return text.data(); }
+                const char *end() const { return text.data() + text.size(); }
+
+                bool more(std::size_t &) { return false; }
+                bool failed() const { return false; }
+
+            private:
+                std::string_view text;
+        };
+
+        // the input read so far from a chunk reader, minus what is consumed
+        class ChunkWindow {
+            public:
+                ChunkWindow(ChunkReader reader, std::size_t chunkSize)
+                    : reader(std::move(reader)), chunkSize(std::max<std::size_t>(chunkSize, 1)), finished(false), broken(false)
+                {
+                }
+
+                const char *begin() const { return buffer.data(); }
+                const char *end() const { return buffer.data() + buffer.size(); }
+
+                /**
+                 * Drops the bytes before pos and reads more after the rest,
+                 * at least as much as is kept so that an element spanning
+                 * many chunks is rescanned only a logarithmic number of times
+                 *
+                 * @return
+                 *     false at the end of input
+                 * */
+                bool more(std::size_t &pos) {
+                    if (finished) {
+                        return false;
+                    }
+
+                    buffer.erase(0, pos);
+                    pos = 0;
+
+                    std::size_t kept = buffer.size();
+                    std::size_t wanted = std::max(chunkSize, kept);
+                    buffer.resize(kept + wanted);
+
+                    std::size_t read = reader(buffer.data() + kept, wanted);
+
+                    if (read == READ_FAILED) {
+                        broken = true;
+                        read = 0;
+                    }
+
+                    buffer.resize(kept + std::min(read, wanted));
+                    finished = (read == 0);
+
+                    return !finished;
+                }
+
+                // whether the reader reported broken input
+                bool failed() const { return broken; }
+
+            private:
+                ChunkReader reader;
+                std::size_t chunkSize;
+                std::string buffer;
+                bool finished;
+                bool broken;
+        };
+    };
+
+    /**
+     * Splits a top-level Array into its elements and parses them one at
+     * a time, the window only ever holds the element being parsed
+     * */
+    class ArrayStream {
+        public:
+            template<typename Window>
+            static Generator<Json> iterate(Window window) {
+                // one parser for all elements keeps its stacks warm
+                Parser parser;
+                std::size_t pos = 0;
+
+                // moves pos to the next byte that is not whitespace
+                auto skipWhitespace = [&window, &pos]() {
+                    while (true) {
+                        const char *next = Scanner::skipWhitespace(window.begin() + pos, window.end());
+                        pos = (std::size_t)(next - window.begin());
+
+                        if (next != window.end()) {
+                            return true;
+                        }
+
+                        if (!window.more(pos)) {
+                            return false;
+                        }
+                    }
+                };
+
+                if (!skipWhitespace() || window.begin()[pos] != '[') {
+                    co_yield Json();
+                    co_return;
+                }
+
+                ++pos;
+
+                if (!skipWhitespace()) {
+                    co_yield Json();
+                    co_return;
+                }
+
+                bool empty = (window.begin()[pos] == ']');
+
+                if (empty) {
+                    ++pos;
+                }
+
+                while (!empty) {
+                    const char *stop = nullptr;
+
+                    // a number may go on in the next chunk
+                    while (true) {
+                        stop = Scanner::skipValue(window.begin() + pos, window.end());
+
+                        if (stop != nullptr && stop != window.end()) {
+                            break;
+                        }
+
+                        // no more input makes a scalar out of nothing
+                        char first = window.begin()[pos];
+
+                        if (stop == nullptr && first != '"' && first != '[' && first != '{') {
+                            break;
+                        }
+
+                        if (!window.more(pos)) {
+                            break;
+                        }
+                    }
+
+                    // a number cut off by broken input is not an element
+                    if (stop == nullptr || window.failed()) {
+                        co_yield Json();
+                        co_return;
+                    }
+
+                    Json element;
+                    bool invalid = !parser.parse(window.begin() + pos, (std::size_t)(stop - (window.begin() + pos)), element);
+                    pos = (std::size_t)(stop - window.begin());
+
+                    co_yield std::move(element);
+
+                    if (invalid || !skipWhitespace()) {
+                        if (!invalid) {
+                            co_yield Json();
+                        }
+
+                        co_return;
+                    }
+
+                    char separator = window.begin()[pos++];
+
+                    if (separator == ']') {
+                        break;
+                    }
+
+                    if (separator != ',' || !skipWhitespace()) {
+                        co_yield Json();
+                        co_return;
+                    }
+                }
+
+                // only whitespace may follow the Array, and the reader may
+                // find the input broken only once it reaches the end
+                if (skipWhitespace() || window.failed()) {
+                    co_yield Json();
+                }
+            }
+    };
+
+    Generator<Json> elements(std::string_view text) {
+        return ArrayStream::iterate(TextWindow{ text });
+    }
+
+    Generator<Json> elements(ChunkReader reader, std::size_t chunkSize) {
+        return ArrayStream::iterate(ChunkWindow{ std::move(reader), chunkSize });
+    }
+
+    Generator<Json> elements(std::istream &input, std::size_t chunkSize) {
+        ChunkReader reader = [&input](char *buffer, std::size_t capacity) {
+            input.read(buffer, (std::streamsize)capacity);
+            return (std::size_t)input.gcount();
+        };
+
+        return elements(std::move(reader), chunkSize);
+    }
+
+}; // namespace JSON
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <optional>
+#include <utility>
+
+namespace JSON {
+
+    /**
+     * A lazily evaluated sequence produced by a coroutine.
+     *
+     * The coroutine runs only when the next value is asked for, and
+     * stops at each `co_yield` until the loop pulls again, so a range
+     * for over a Generator holds one value at a time. Exceptions thrown
+     * by the coroutine come out of the iterator that resumed it.
+     * */
+    template<typename T>
+    class Generator {
+        public:
+            struct promise_type {
+                std::optional<T> current;
+                std::exception_ptr exception;
+
+                Generator get_return_object() {
+                    return Generator{ std::coroutine_handle<promise_type>::from_promise(*this) };
+                }
+
+                std::suspend_always initial_suspend() noexcept { return {}; }
+                std::suspend_always final_suspend() noexcept { return {}; }
+
+                std::suspend_always yield_value(T value) {
+                    current = std::move(value);
+                    return {};
+                }
+
+                void return_void() {}
+
+                void unhandled_exception() {
+                    exception = std::current_exception();
+                }
+            };
+
+            using Handle = std::coroutine_handle<promise_type>;
+
+            class iterator {
+                public:
+                    using iterator_category = std::input_iterator_tag;
+                    using value_type = T;
+                    using difference_type = std::ptrdiff_t;
+                    using pointer = T *;
+                    using reference = T &;
+
+                    iterator() = default;
+                    explicit iterator(Handle handle) : handle(handle) {}
+
+                    T &operator*() const { return *handle.promise().current; }
+                    T *operator->() const { return &*handle.promise().current; }
+
+                    iterator &operator++() {
+                        advance(handle);
+                        return *this;
+                    }
+
+                    void operator++(int) { ++*this; }
+
+                    bool operator==(std::default_sentinel_t) const {
+                        return !handle || handle.done();
+                    }
+
+                private:
+                    Handle handle;
+            };
+
+            explicit Generator(Handle handle) : handle(handle) {}
+
+            Generator(Generator &&other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+
+            Generator &operator=(Generator &&other) noexcept {
+                if (this != &other) {
+                    if (handle) {
+                        handle.destroy();
+                    }
+
+                    handle = std::exchange(other.handle, nullptr);
+                }
+
+                return *this;
+            }
+
+            Generator(const Generator &) = delete;
+            Generator &operator=(const Generator &) = delete;
+
+            ~Generator() {
+                if (handle) {
+                    handle.destroy();
+                }
+            }
+
+            // runs the coroutine up to its first value
+            iterator begin() {
+                advance(handle);
+                return iterator{ handle };
+            }
+
+            std::default_sentinel_t end() const {
+                return {};
+            }
+
+        private:
+            static void advance(Handle handle) {
+                if (!handle || handle.done()) {
+                    return;
+                }
+
+                handle.promise().current.reset();
+                handle.resume();
+
+                if (handle.promise().exception) {
+                    std::rethrow_exception(std::exchange(handle.promise().exception, nullptr));
+                }
+            }
+
+        private:
+            Handle handle;
+    };
+
+}; // namespace JSON
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace JSON {
+
+    namespace Hash {
+
+        /**
+         * This function computes the 64-bit xxHash (XXH64) digest
+         * of the given block of memory
+         *
+         * @param[in] data
+         *     Pointer to the first byte to be hashed.
+         *
+         * @param[in] size
+         *     Number of bytes to be hashed.
+         *
+         * @param[in] seed
+         *     Seed value, different seeds give independent hashes.
+         *
+         * @return
+         *     The 64-bit digest
+         * */
+        std::uint64_t xxh64(const void *data, std::size_t size, std::uint64_t seed = 0);
+    };
+};
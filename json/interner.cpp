@@ -0,0 +1,88 @@
+#include "interner.hpp"
+
+namespace JSON {
+
+    Interner::Interner(std::size_t maxContainerSize)
+        : maxContainerSize(maxContainerSize)
+    {
+    }
+
+    void Interner::intern(Json &json) {
+        switch (json.type) {
+            case Json::Type::String: {
+                auto &string = std::get<Json::Type::String>(json.value);
+                auto found = strings.find(*string);
+
+                if (found != strings.end()) {
+                    string = found->second;
+                } else {
+                    strings.emplace(*string, string);
+                }
+            } break;
+
+            case Json::Type::Array:
+            case Json::Type::Object: {
+                if (json.size() > maxContainerSize) {
+                    break;
+                }
+
+                std::uint64_t hash = json.hash();
+                auto range = containers.equal_range(hash);
+
+                for (auto candidate = range.first; candidate != range.second; ++candidate) {
+                    // the children are interned, so equal children are
+                    // the same nodes and equals() compares pointers
+                    if (candidate->second.equals(json)) {
+                        json.value = candidate->second.value;
+                        return;
+                    }
+                }
+
+                containers.emplace(hash, json);
+            } break;
+
+            default: break;
+        }
+    }
+
+    void Interner::internTree(Json &json) {
+        const void *node = nullptr;
+
+        if (json.type == Json::Type::Array) {
+            node = std::get<Json::Type::Array>(json.value).get();
+        } else if (json.type == Json::Type::Object) {
+            node = std::get<Json::Type::Object>(json.value).get();
+        }
+
+        // packed numbers have no nodes to share, and detach() would unpack them
+        if (json.isPacked()) {
+            intern(json);
+            return;
+        }
+
+        // a container reached a second time is interned already
+        if (node != nullptr && visited.count(node) == 0) {
+            json.detach();
+
+            if (json.type == Json::Type::Array) {
+                auto &elements = *(std::get<Json::Type::Array>(json.value));
+
+                for (auto &element : elements) {
+                    internTree(element);
+                }
+
+                visited.emplace(&elements, json);
+            } else {
+                auto &members = *(std::get<Json::Type::Object>(json.value));
+
+                for (auto &member : members) {
+                    internTree(member.second);
+                }
+
+                visited.emplace(&members, json);
+            }
+        }
+
+        intern(json);
+    }
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string_view>
+#include <unordered_map>
+
+#include "json.hpp"
+
+namespace JSON {
+
+    /**
+     * Hash-consing table for Json values.
+     *
+     * Equal strings, and equal Arrays and Objects up to a given size,
+     * are replaced with one shared node. Shared nodes are safe to modify
+     * since the containers of a Json value are copied on write.
+     * */
+    class Interner {
+        public:
+            explicit Interner(std::size_t maxContainerSize);
+
+            /**
+             * This method replaces the node of a single Json value with an
+             * equal node seen before, its children must be interned already
+             * */
+            void intern(Json &json);
+
+            /**
+             * This method interns a whole tree, children before parents
+             * */
+            void internTree(Json &json);
+
+        private:
+            std::size_t maxContainerSize;
+            std::unordered_map<std::string_view, Json::JsonString> strings;
+            std::unordered_multimap<std::uint64_t, Json> containers;
+
+            // containers already walked, the handles keep their addresses
+            // from being reused by new containers
+            std::unordered_map<const void *, Json> visited;
+    };
+};
@@ -1,9 +1,66 @@
+#include <algorithm>
+#include <charconv>
 #include <cstdlib>
+#include <stdexcept>
 
+#include "interner.hpp"
 #include "json.hpp"
+#include "parser.hpp"
+#include "scanner.hpp"
 
 namespace JSON {
 
+    namespace {
+
+        constexpr int MAX_DESTRUCTION_DEPTH = 64;
+
+        thread_local int destructionDepth = 0;
+        thread_local bool destructionDraining = false;
+        thread_local std::vector<Json> deferredDestruction;
+
+        /**
+         * Tracks whether the legacy splitters are inside a string so
+         * that escaped quotes and brackets in strings are not mistaken
+         * for structure
+         *
+         * @return
+         *     true if c is part of a string, including its quotes
+         * */
+        bool insideString(char c, bool &inString, bool &escaped) {
+            if (!inString) {
+                inString = (c == '"');
+                return inString;
+            }
+
+            if (escaped) {
+                escaped = false;
+            } else if (c == '\\') {
+                escaped = true;
+            } else if (c == '"') {
+                inString = false;
+            }
+
+            return true;
+        }
+
+        // member names are kept raw while splitting, with their escapes
+        std::string decodeName(const std::string &raw) {
+            if (raw.find('\\') == std::string::npos) {
+                return raw;
+            }
+
+            std::string quoted = '"' + raw + '"';
+            std::string name;
+            const char *error = nullptr;
+
+            if (Scanner::decodeString(quoted.data(), quoted.data() + quoted.size(), name, error) == nullptr) {
+                return raw;
+            }
+
+            return name;
+        }
+    };
+
     const char *WrongTypeException::what() const noexcept {
         return "Attempt to perform an operation on the wrong Json Type";
     }
@@ -14,6 +71,11 @@ namespace JSON {
     }
 
     Json::Json(const Type &type) 
+        : Json(type, nullptr)
+    {
+    }
+
+    Json::Json(const Type &type, std::pmr::memory_resource *resource)
         : type(type)
     {
         switch (type) {
@@ -22,61 +84,63 @@ namespace JSON {
             } break;
 
             case Type::Integer: {
-                value = (long long)0;
+                value.emplace<Type::Integer>(0LL);
             } break;
 
             case Type::FloatingPoint: {
-                value = (long double)0.0;
+                value.emplace<Type::FloatingPoint>((long double)0.0);
             } break;
 
             case Type::String: {
-                value = new std::string();
+                value = allocate<Text>(resource);
             } break;
 
             case Type::Array: {
-                value = new std::vector<Json *>();
+                value = allocate<Elements>(resource);
             } break;
 
             case Type::Object: {
-                value = new std::unordered_map<std::string, Json *>();
+                value = allocate<Members>(resource);
             } break;
         }
     }
 
-    Json::Json(const Json *other) {
-        type = other->type;
+    Json::Json(const Json *other) 
+        : type(other->type), value(other->value)
+    {
+        // containers are shared, not copied
+    }
 
-        switch (type) {
-            case Type::Boolean: {
-                value = std::get<Type::Boolean>(other->value);
-            } break;
+    Json::~Json() {
+        bool container =
+            (type == Type::Array && std::get<Type::Array>(value)) ||
+            (type == Type::Object && std::get<Type::Object>(value));
 
-            case Type::Integer: {
-                value = std::get<Type::Integer>(other->value);
-            } break;
+        if (!container) {
+            return;
+        }
 
-            case Type::FloatingPoint: {
-                value = std::get<Type::FloatingPoint>(other->value);
-            } break;
+        // nested containers are destroyed recursively only up to a small
+        // depth, deeper ones are left to the outermost destructor
+        if (destructionDepth >= MAX_DESTRUCTION_DEPTH) {
+            deferredDestruction.push_back(std::move(*this));
+            return;
+        }
 
-            case Type::String: {
-                value = new std::string(*(std::get<Type::String>(other->value)));
-            } break;
+        ++destructionDepth;
+        value = false;
+        --destructionDepth;
 
-            case Type::Array: {
-                value = new std::vector<Json *>(*(std::get<Type::Array>(other->value)));
-            } break;
+        if (destructionDepth == 0 && !destructionDraining) {
+            destructionDraining = true;
 
-            case Type::Object: {
-                value = 
-                    new std::unordered_map<std::string, Json *>
-                    (*(std::get<Type::Object>(other->value)));
-            } break;
-        }
-    }
+            while (!deferredDestruction.empty()) {
+                Json deferred = std::move(deferredDestruction.back());
+                deferredDestruction.pop_back();
+            }
 
-    Json::~Json() {
-        // do nothing
+            destructionDraining = false;
+        }
     }
 
     Json *Json::parseBoolean(const std::string &input) {
@@ -130,6 +194,22 @@ namespace JSON {
 
     Json *Json::parseInteger(const std::string &input) {
         Json *json = new Json();
+
+        // a well-formed integer is only converted when it is read
+        const char *end = input.data() + input.size();
+        const char *error = nullptr;
+
+        if (!input.empty() && Scanner::validateNumber(input.data(), end, error) == end) {
+            Number number(input, nullptr);
+
+            if (number.isIntegral()) {
+                json->type = Type::Integer;
+                json->value.emplace<Type::Integer>(std::move(number));
+
+                return json;
+            }
+        }
+
         long long result = 0;
         bool negative = false;
 
@@ -157,7 +237,7 @@ namespace JSON {
         }
 
         json->type = Type::Integer;
-        json->value = result;    
+        json->value.emplace<Type::Integer>(result);
 
         return json;
     }
@@ -245,13 +325,13 @@ namespace JSON {
         json->type = Type::FloatingPoint;
 
         if (!power) {
-            json->value = result;
+            json->value.emplace<Type::FloatingPoint>(result);
         } else {
             if (negPower) {
                 powerValue *= -1;
             }
 
-            json->value = (long double)std::pow(result, powerValue);
+            json->value.emplace<Type::FloatingPoint>((long double)std::pow(result, powerValue));
         }
 
         return json;
@@ -259,27 +339,15 @@ namespace JSON {
 
     Json *Json::parseString(const std::string &input) {
         Json *json = new Json();
-        bool foundEndQoute = false;
         std::string extractedString = "";
+        const char *error = nullptr;
 
-        for (int i = 1; i < input.size(); ++i) {
-            
-            const char &c = input.at(i);
-
-            if (c == '"') {
-                foundEndQoute = true;
-                break;
-            }
-
-            extractedString.push_back(c);
-        }
-
-        if (!foundEndQoute) {
+        if (input.empty() || Scanner::decodeString(input.data(), input.data() + input.size(), extractedString, error) == nullptr) {
             return json;
         }
 
         json->type = Type::String;
-        json->value = new std::string(extractedString);
+        json->value = allocate<Text>(nullptr, extractedString);
         
         return json;
     }
@@ -293,6 +361,8 @@ namespace JSON {
         int closeBrackets = 0;
         int openBrace = 0;
         int closeBrace = 0;
+        bool inString = false;
+        bool escaped = false;
         std::string element = "";
         std::vector<std::string> elements;
 
@@ -331,15 +401,21 @@ namespace JSON {
                 } break;
 
                 case 1: { // string double-quote mark
-                    if (c == '"') {
+                    if (escaped) {
+                        escaped = false;
+                    } else if (c == '\\') {
+                        escaped = true;
+                    } else if (c == '"') {
                         state = 0;
-                    } 
+                    }
 
                     element.push_back(c);
                 } break;
 
                 case 2: { // opening bracket
-                    if (c == '[') {
+                    if (insideString(c, inString, escaped)) {
+                        // brackets inside strings do not count
+                    } else if (c == '[') {
                         openBrackets++;
                     } else if (c == ']') {
                         closeBrackets++;
@@ -352,7 +428,9 @@ namespace JSON {
                 } break;
                 
                 case 3: { // opening brace
-                    if (c == '{') {
+                    if (insideString(c, inString, escaped)) {
+                        // braces inside strings do not count
+                    } else if (c == '{') {
                         openBrace++;
                     } else if (c == '}') {
                         closeBrace++;
@@ -370,63 +448,15 @@ namespace JSON {
             return json;
         }
 
-        auto jsonArray = new std::vector<Json *>();
+        auto jsonArray = allocate<Elements>(nullptr);
+        jsonArray->reserve(elements.size());
 
         for (const auto &e : elements) {
-            
-            Json *value = nullptr;
-            
-            switch (e.front()) {
-                case '0':
-                case '1':
-                case '2':
-                case '3':
-                case '4':
-                case '5':
-                case '6':
-                case '7':
-                case '8':
-                case '9':
-                case '-': {
-                    int pointPos = e.find_first_of(".eE");
-
-                    if (pointPos == std::string::npos) {
-                        value = parseInteger(e);
-                    } else {
-                        value = parseFloatingPoint(e);
-                    }
-                    
-                    jsonArray->push_back(value);
-                } break;
-
-                case '"': {
-                    value = parseString(e);
-                    jsonArray->push_back(value);
-                } break;
+            Json *value = parseValue(e);
 
-                case 'T':
-                case 'F':
-                case 't':
-                case 'f': {
-                    value = parseBoolean(e);
-                    jsonArray->push_back(value);
-                } break;
-
-                case 'N':
-                case 'n': {
-                    value = parseNull(e);
-                    jsonArray->push_back(value);
-                } break;
-
-                case '[': {
-                    value = parseArray(e);
-                    jsonArray->push_back(value);
-                } break;
-
-                case '{': {
-                    value = parseObject(e);
-                    jsonArray->push_back(value);
-                } break;
+            if (value != nullptr) {
+                jsonArray->push_back(std::move(*value));
+                delete value;
             }
         }
         
@@ -453,6 +483,8 @@ namespace JSON {
         
         bool memberName = true;
         bool foundEndBrace = false;
+        bool inString = false;
+        bool escaped = false;
 
         for (int i = 1; i < input.size(); ++i) {
             const auto &c = input.at(i);
@@ -553,19 +585,23 @@ namespace JSON {
                 } break;
 
                 case 1: { // string double-quote mark
-                    if (memberName) {
-                        if (c != '"') {
-                            name.push_back(c);
-                        } else {
+                    if (escaped) {
+                        escaped = false;
+                    } else if (c == '\\') {
+                        escaped = true;
+                    } else if (c == '"') {
+                        state = 0;
+
+                        if (memberName) {
                             memberName = false;
-                            state = 0;
+                            break;
                         }
+                    }
+
+                    if (memberName) {
+                        name.push_back(c);
                     } else {
                         content.push_back(c);
-
-                        if (c == '"') {
-                            state = 0;
-                        }
                     }
                 } break;
 
@@ -573,7 +609,9 @@ namespace JSON {
                     if (!memberName) {
                         content.push_back(c);
 
-                        if (c == '[') {
+                        if (insideString(c, inString, escaped)) {
+                            // brackets inside strings do not count
+                        } else if (c == '[') {
                             openBracket++;
                         } else if (c == ']') {
                             closeBracket++;
@@ -589,7 +627,9 @@ namespace JSON {
                     if (!memberName) {
                         content.push_back(c);
 
-                        if (c == '{') {
+                        if (insideString(c, inString, escaped)) {
+                            // braces inside strings do not count
+                        } else if (c == '{') {
                             openBrace++;
                         } else if (c == '}') {
                             closeBrace++;
@@ -608,59 +648,14 @@ namespace JSON {
             return json;
         }
 
-        auto *object = new std::unordered_map<std::string, Json *>();
+        auto object = allocate<Members>(nullptr);
 
         for (const auto &member : members) {
-            Json *value = nullptr;
-            
-            switch (member.second.front()) {
-                case 'n': {
-                    value = parseNull(member.second);
-                    (*(object))[member.first] = value;        
-                } break;
-
-                case 'f':
-                case 't': {
-                    value = parseBoolean(member.second);
-                    (*(object))[member.first] = value; 
-                } break;
-
-                case '0':
-                case '1':
-                case '2':
-                case '3':
-                case '4':
-                case '5':
-                case '6':
-                case '7':
-                case '8':
-                case '9':
-                case '-': {
-                    int pointPos = member.second.find_first_of(".eE");
-                    
-                    if (pointPos == std::string::npos) {
-                        value = parseInteger(member.second);
-                    } else {
-                        value = parseFloatingPoint(member.second);
-                    }
+            Json *value = parseValue(member.second);
 
-                    (*(object))[member.first] = value; 
-                } break;
-
-                case '"': {
-                    value = parseString(member.second);
-                    (*(object))[member.first] = value; 
-                } break;
-
-                case '[': {
-                    value = parseArray(member.second);
-                    (*(object))[member.first] = value; 
-                } break;
-
-                case '{': {
-                    value = parseObject(member.second);
-                    (*(object))[member.first] = value; 
-                } break;
+            if (value != nullptr) {
+                object->insert_or_assign(Text(decodeName(member.first), object->get_allocator()), std::move(*value));
+                delete value;
             }
         }
 
@@ -670,43 +665,74 @@ namespace JSON {
         return json;
     }
 
-    Json *Json::fromCppString(const std::string &input) {
-        Json *json = new Json();
-        int charFound = 0;
-        bool object = false;
-        bool array = false;
+    Json *Json::parseValue(const std::string &input) {
+        Json *value = nullptr;
 
-        for (const auto &c : input) {
-            if (c == '{') {
-                if (charFound == 0) {
-                    object = true;
-                    break;
-                }
-            } else if (c == '[') {
-                if (charFound == 0) {
-                    array = true;
-                    break;
-                }
-            } else if (c == ' ' || c == '\n' || c == '\t' || c == '\r') {
-                // do nothing
-            } else {
-                charFound++;
-            }
+        if (input.empty()) {
+            return value;
         }
 
-        if (!object && !array) {
-            return json;
-        } else if (object) {
-            delete json;
-            json = parseObject(input);
-        } else if (array) {
-            delete json;
-            json = parseArray(input);
+        switch (input.front()) {
+            case '0':
+            case '1':
+            case '2':
+            case '3':
+            case '4':
+            case '5':
+            case '6':
+            case '7':
+            case '8':
+            case '9':
+            case '-': {
+                int pointPos = input.find_first_of(".eE");
+
+                if (pointPos == std::string::npos) {
+                    value = parseInteger(input);
+                } else {
+                    value = parseFloatingPoint(input);
+                }
+            } break;
+
+            case '"': {
+                value = parseString(input);
+            } break;
+
+            case 'T':
+            case 'F':
+            case 't':
+            case 'f': {
+                value = parseBoolean(input);
+            } break;
+
+            case 'N':
+            case 'n': {
+                value = parseNull(input);
+            } break;
+
+            case '[': {
+                value = parseArray(input);
+            } break;
+
+            case '{': {
+                value = parseObject(input);
+            } break;
         }
 
+        return value;
+    }
+
+    Json *Json::fromCppString(const std::string &input, const ParseOptions &options) {
+        Json *json = new Json();
+        Parser parser{ options };
+        parser.parse(input.data(), input.size(), *json);
+
         return json;
     }
 
+    Json *Json::fromCppString(const std::string &input) {
+        return fromCppString(input, ParseOptions{});
+    }
+
     bool Json::operator==(nullptr_t null) const {
         if (type == Type::Null) {
             return true;
@@ -734,29 +760,19 @@ namespace JSON {
     }
 
     bool Json::operator==(int integer) const {
-        if (type != Type::Integer) {
-            throw WrongTypeException();
-        }
-
-        return std::get<Type::Integer>(value) == (long long)integer;
+        return *this == (long long)integer;
     }
 
     void Json::operator=(int integer) {
-        type = Type::Integer;
-        value = (long long)integer;
+        *this = (long long)integer;
     }
 
     bool Json::operator==(long integer) const {
-        if (type != Type::Integer) {
-            throw WrongTypeException();
-        }
-
-        return std::get<Type::Integer>(value) == (long long)integer;
+        return *this == (long long)integer;
     }
 
     void Json::operator=(long integer) {
-        type = Type::Integer;
-        value = (long long)integer;
+        *this = (long long)integer;
     }
 
     bool Json::operator==(long long integer) const {
@@ -764,40 +780,45 @@ namespace JSON {
             throw WrongTypeException();
         }
 
-        return std::get<Type::Integer>(value) == integer;
+        const Number &number = std::get<Type::Integer>(value);
+
+        return number.getClass() == Number::Class::Int64 && number.toInt64() == integer;
     }
 
     void Json::operator=(long long integer) {
         type = Type::Integer;
-        value = integer;
+        value.emplace<Type::Integer>(integer);
     }
 
-    bool Json::operator==(float floatingPoint) const {
-        if (type != Type::FloatingPoint) {
+    bool Json::operator==(unsigned long long integer) const {
+        if (type != Type::Integer) {
             throw WrongTypeException();
         }
 
-        return (std::get<Type::FloatingPoint>(value) >= (long double)floatingPoint - 0.01) &&
-                (std::get<Type::FloatingPoint>(value) <= (long double)floatingPoint + 0.01);
+        const Number &number = std::get<Type::Integer>(value);
+
+        return number.getClass() != Number::Class::Big && number.toUInt64() == integer;
+    }
+
+    void Json::operator=(unsigned long long integer) {
+        type = Type::Integer;
+        value.emplace<Type::Integer>(integer);
+    }
+
+    bool Json::operator==(float floatingPoint) const {
+        return *this == (long double)floatingPoint;
     }
 
     void Json::operator=(float floatingPoint) {
-        type = Type::FloatingPoint;
-        value = (long double)floatingPoint;
+        *this = (long double)floatingPoint;
     }
 
     bool Json::operator==(double floatingPoint) const {
-        if (type != Type::FloatingPoint) {
-            throw WrongTypeException();
-        }
-
-        return (std::get<Type::FloatingPoint>(value) >= (long double)floatingPoint - 0.01) &&
-                (std::get<Type::FloatingPoint>(value) <= (long double)floatingPoint + 0.01);
+        return *this == (long double)floatingPoint;
     }
 
     void Json::operator=(double floatingPoint) {
-        type = Type::FloatingPoint;
-        value = (long double)floatingPoint;
+        *this = (long double)floatingPoint;
     }
     
     bool Json::operator==(long double floatingPoint) const {
@@ -805,13 +826,14 @@ namespace JSON {
             throw WrongTypeException();
         }
 
-        return (std::get<Type::FloatingPoint>(value) >= floatingPoint - 0.01) &&
-                (std::get<Type::FloatingPoint>(value) <= floatingPoint + 0.01);
+        long double number = std::get<Type::FloatingPoint>(value).toLongDouble();
+
+        return (number >= floatingPoint - 0.01) && (number <= floatingPoint + 0.01);
     }
 
     void Json::operator=(long double floatingPoint) {
         type = Type::FloatingPoint;
-        value = floatingPoint;
+        value.emplace<Type::FloatingPoint>(floatingPoint);
     }
 
 
@@ -821,17 +843,17 @@ namespace JSON {
             throw WrongTypeException();
         }
 
-        return *(std::get<Type::String>(value)) == string;
+        return std::string_view(*(std::get<Type::String>(value))) == string;
     }
 
     void Json::operator=(const std::string &string) {
         type = Type::String;
-        value = new std::string(string);
+        value = allocate<Text>(nullptr, string);
     }
 
     bool Json::operator==(const char *string) const {
         if (type == Type::String) {
-            if (*(std::get<Type::String>(value)) == std::string(string)) {
+            if (*(std::get<Type::String>(value)) == string) {
                 return true;
             }
         }
@@ -841,26 +863,20 @@ namespace JSON {
 
     void Json::operator=(const char *string) {
         type = Type::String;
-        value = new std::string(string);
+        value = allocate<Text>(nullptr, string);
     }
 
 
-    bool Json::operator==(const Json &other) const {
-        if (type == other.type) {
-
-            if (value == other.value) {
-                return true;
-            }
-        } 
-        
-        return false;
-    }
-
     void Json::operator=(const Json &other) {
         type = other.type;
         value = other.value;
     }
 
+    void Json::operator=(Json &&other) noexcept {
+        type = other.type;
+        value = std::move(other.value);
+    }
+
     void Json::operator=(const Json *other) {
         type = other->type;
         value = other->value;
@@ -872,7 +888,7 @@ namespace JSON {
             throw WrongTypeException();
         }
 
-        return *( std::get<Type::Array>(value)->at(index) );
+        return std::get<Type::Array>(value)->element(index);
     }
 
     Json Json::operator[](const char *key) const {
@@ -880,9 +896,229 @@ namespace JSON {
             throw WrongTypeException();
         }
 
-        return *( std::get<Type::Object>(value)->at( std::string(key) ) );
+        const Json *found = member(std::string_view(key));
+
+        if (found == nullptr) {
+            throw std::out_of_range("Json::operator[]: no such member");
+        }
+
+        return *found;
+    }
+
+    Json Json::operator[](const Key &key) const {
+        if (type != Type::Object) {
+            throw WrongTypeException();
+        }
+
+        const Json *found = member(key);
+
+        if (found == nullptr) {
+            throw std::out_of_range("Json::operator[]: no such member");
+        }
+
+        return *found;
+    }
+
+    template<typename Name>
+    const Json *Json::member(const Name &name) const {
+        if (type != Type::Object) {
+            return nullptr;
+        }
+
+        // heterogeneous lookup, the name is neither copied nor converted
+        const auto &members = *(std::get<Type::Object>(value));
+        auto found = members.find(name);
+
+        return found == members.end() ? nullptr : &found->second;
+    }
+
+    const Json *Json::find(std::string_view key) const {
+        return member(key);
+    }
+
+    const Json *Json::find(const Key &key) const {
+        return member(key);
+    }
+
+
+    void Json::detach() {
+        // called before every modification of a container: the container
+        // is cloned if it is shared and its cached hash is dropped
+        switch (type) {
+            case Type::String: {
+                auto &string = std::get<Type::String>(value);
+
+                if (string.use_count() > 1) {
+                    string = allocate<Text>(string->get_allocator().resource(), *string);
+                }
+            } break;
+
+            case Type::Array: {
+                auto &elements = std::get<Type::Array>(value);
+
+                // the elements are copied as handles, so they keep sharing
+                // their own containers until they are modified
+                if (elements.use_count() > 1) {
+                    elements = allocate<Elements>(elements->get_allocator().resource(), *elements);
+                }
+
+                // packed numbers are only ever read, a modification needs Json values
+                elements->unpack();
+                elements->hash.store(0, std::memory_order_relaxed);
+            } break;
+
+            case Type::Object: {
+                auto &members = std::get<Type::Object>(value);
+
+                if (members.use_count() > 1) {
+                    members = allocate<Members>(members->get_allocator().resource(), *members);
+                }
+
+                members->hash.store(0, std::memory_order_relaxed);
+            } break;
+
+            default: break;
+        }
+    }
+
+    Json &Json::at(int index) {
+        if (type != Type::Array) {
+            throw WrongTypeException();
+        }
+
+        detach();
+
+        return std::get<Type::Array>(value)->at(index);
+    }
+
+    Json &Json::at(std::string_view key) {
+        return at(Key(key));
+    }
+
+    Json &Json::at(const Key &key) {
+        if (type != Type::Object) {
+            throw WrongTypeException();
+        }
+
+        detach();
+        auto &members = *(std::get<Type::Object>(value));
+        auto member = members.find(key);
+
+        if (member == members.end()) {
+            throw std::out_of_range("Json::at: no such member");
+        }
+
+        return member->second;
+    }
+
+    const Json &Json::at(int index) const {
+        if (type != Type::Array) {
+            throw WrongTypeException();
+        }
+
+        return std::get<Type::Array>(value)->materialized().at(index);
+    }
+
+    const Json &Json::at(std::string_view key) const {
+        return at(Key(key));
+    }
+
+    const Json &Json::at(const Key &key) const {
+        if (type != Type::Object) {
+            throw WrongTypeException();
+        }
+
+        const Json *found = member(key);
+
+        if (found == nullptr) {
+            throw std::out_of_range("Json::at: no such member");
+        }
+
+        return *found;
+    }
+
+    void Json::append(const Json &element) {
+        if (type != Type::Array) {
+            throw WrongTypeException();
+        }
+
+        detach();
+        std::get<Type::Array>(value)->push_back(element);
+    }
+
+    void Json::insert(int index, const Json &element) {
+        if (type != Type::Array) {
+            throw WrongTypeException();
+        }
+
+        detach();
+        auto &elements = *(std::get<Type::Array>(value));
+
+        if (index < 0 || (std::size_t)index > elements.size()) {
+            throw std::out_of_range("Json::insert");
+        }
+
+        elements.insert(elements.begin() + index, element);
+    }
+
+    void Json::insert(const std::string &key, const Json &member) {
+        if (type != Type::Object) {
+            throw WrongTypeException();
+        }
+
+        detach();
+        auto &members = *(std::get<Type::Object>(value));
+        auto found = members.find(key);
+
+        if (found != members.end()) {
+            found->second = member;
+        } else {
+            members.emplace(Text(key, members.get_allocator()), member);
+        }
+    }
+
+    void Json::erase(int index) {
+        if (type != Type::Array) {
+            throw WrongTypeException();
+        }
+
+        detach();
+        auto &elements = *(std::get<Type::Array>(value));
+
+        if (index < 0 || (std::size_t)index >= elements.size()) {
+            throw std::out_of_range("Json::erase");
+        }
+
+        elements.erase(elements.begin() + index);
+    }
+
+    void Json::erase(const std::string &key) {
+        if (type != Type::Object) {
+            throw WrongTypeException();
+        }
+
+        detach();
+        auto &members = *(std::get<Type::Object>(value));
+        auto found = members.find(key);
+
+        if (found != members.end()) {
+            members.erase(found);
+        }
+    }
+
+    std::size_t Json::size() const {
+        switch (type) {
+            case Type::String: return std::get<Type::String>(value)->size();
+            case Type::Array: return std::get<Type::Array>(value)->count();
+            case Type::Object: return std::get<Type::Object>(value)->size();
+            default: throw WrongTypeException();
+        }
     }
 
+    void Json::deduplicate(std::size_t maxSharedSize) {
+        Interner interner(maxSharedSize);
+        interner.internTree(*this);
+    }
 
     Json::Type Json::getType() const {
         return type;
@@ -892,32 +1128,106 @@ namespace JSON {
         return std::get<Type::Boolean>(value);
     }
 
+    bool Json::isPacked() const {
+        return type == Type::Array && std::get<Type::Array>(value)->isPacked();
+    }
+
+    std::span<const std::int64_t> Json::integers() const {
+        const Elements::Integers *integers = (type == Type::Array) ? std::get_if<Elements::Integers>(&std::get<Type::Array>(value)->packed) : nullptr;
+
+        if (integers == nullptr) {
+            throw WrongTypeException();
+        }
+
+        return *integers;
+    }
+
+    std::span<const double> Json::doubles() const {
+        const Elements::Doubles *doubles = (type == Type::Array) ? std::get_if<Elements::Doubles>(&std::get<Type::Array>(value)->packed) : nullptr;
+
+        if (doubles == nullptr) {
+            throw WrongTypeException();
+        }
+
+        return *doubles;
+    }
+
+    Json Json::fromPacked(std::int64_t integer, std::pmr::memory_resource *) {
+        Json json;
+        json = (long long)integer;
+
+        return json;
+    }
+
+    Json Json::fromPacked(double floatingPoint, std::pmr::memory_resource *resource) {
+        // the shortest digits that read back as the same double, with a
+        // fraction so that they still read as FloatingPoint
+        char digits[32];
+        char *end = std::to_chars(digits, digits + sizeof(digits) - 2, floatingPoint).ptr;
+
+        if (std::find_if(digits, end, [](char c) { return c == '.' || c == 'e'; }) == end) {
+            *end++ = '.';
+            *end++ = '0';
+        }
+
+        Json json;
+        json.type = Type::FloatingPoint;
+        json.value.emplace<Type::FloatingPoint>(std::string_view(digits, (std::size_t)(end - digits)), resource);
+
+        return json;
+    }
+
+    const Number &Json::getNumber() const {
+        switch (type) {
+            case Type::Integer: return std::get<Type::Integer>(value);
+            case Type::FloatingPoint: return std::get<Type::FloatingPoint>(value);
+            default: throw WrongTypeException();
+        }
+    }
+
     Json::operator int() {
-        return (int)std::get<Type::Integer>(value);
+        return (int)(long long)*this;
     }
 
     Json::operator long() {
-        return (long)std::get<Type::Integer>(value);
+        return (long)(long long)*this;
     }
 
     Json::operator long long() {
-        return std::get<Type::Integer>(value);
+        Number &number = std::get<Type::Integer>(value);
+        number.convert();
+
+        return number.toInt64();
+    }
+
+    Json::operator unsigned long long() {
+        Number &number = std::get<Type::Integer>(value);
+        number.convert();
+
+        return number.toUInt64();
     }
 
     Json::operator float() {
-        return (float)std::get<Type::FloatingPoint>(value);
+        return (float)(double)*this;
     }
 
     Json::operator double() {
-        return (double)std::get<Type::FloatingPoint>(value);
+        // integers too large for 64 bits are read as floating point
+        Number &number = (type == Type::Integer) ? std::get<Type::Integer>(value) : std::get<Type::FloatingPoint>(value);
+        number.convert();
+
+        return number.toDouble();
     }
 
     Json::operator long double() {
-        return (long double)std::get<Type::FloatingPoint>(value);
+        const Number &number = (type == Type::Integer) ? std::get<Type::Integer>(value) : std::get<Type::FloatingPoint>(value);
+
+        return number.toLongDouble();
     }
 
     Json::operator std::string() {
-        return *( std::get<Type::String>(value) );
+        const auto &string = *( std::get<Type::String>(value) );
+        return std::string(string.data(), string.size());
     }
 
     std::ostream &operator<<(std::ostream &output, const Json &json) {
@@ -931,20 +1241,41 @@ namespace JSON {
                     output << "false";
                 }
                 break;
-            case Json::Type::Integer: output << std::get<Json::Type::Integer>(json.value); break;
-            case Json::Type::FloatingPoint: output << std::get<Json::Type::FloatingPoint>(json.value); break;
+            case Json::Type::Integer:
+            case Json::Type::FloatingPoint: {
+                const Number &number = json.getNumber();
+
+                // parsed numbers are written back exactly as they were read
+                if (!number.text().empty()) {
+                    output << number.text();
+                } else if (json.type == Json::Type::FloatingPoint) {
+                    output << number.toLongDouble();
+                } else if (number.getClass() == Number::Class::UInt64) {
+                    output << number.toUInt64();
+                } else {
+                    output << number.toInt64();
+                }
+            } break;
             case Json::Type::String: output << *( std::get<Json::Type::String>(json.value) ); break;
             case Json::Type::Array:
                 output << "[ ";
-                for (const auto &element : *( std::get<Json::Type::Array>(json.value) ) ) {
-                    output << *element << ", ";
+                if (json.isPacked()) {
+                    const auto &elements = *( std::get<Json::Type::Array>(json.value) );
+
+                    for (std::size_t i = 0; i < elements.count(); ++i) {
+                        output << elements.element(i) << ", ";
+                    }
+                } else {
+                    for (const auto &element : *( std::get<Json::Type::Array>(json.value) ) ) {
+                        output << element << ", ";
+                    }
                 }
                 output << "]";
                 break;
             case Json::Type::Object:
                 output << "\n{\n";
                 for (const auto &pair: *( std::get<Json::Type::Object>(json.value) ) ) {
-                    output << '\t' << pair.first << ": " << *pair.second << ',' << std::endl;
+                    output << '\t' << pair.first << ": " << pair.second << ',' << std::endl;
                 }
                 output << "}\n";
                 break;
@@ -1,10 +1,24 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <unordered_map>
 #include <exception>
+#include <functional>
+#include <istream>
+#include <memory_resource>
 #include <ostream>
+#include <span>
+#include <string_view>
 #include <variant>
 
+#include "generator.hpp"
+#include "memory.hpp"
+#include "number.hpp"
 #include "utility.hpp"
 
 namespace JSON {
@@ -16,13 +30,276 @@ namespace JSON {
     };
 
 
+    /**
+     * A replacement of `length` bytes at `offset` of a JSON text
+     * with the bytes of `replacement`
+     * */
+    struct TextEdit {
+        std::size_t offset;
+        std::size_t length;
+        std::string replacement;
+    };
+
+
+    /**
+     * Options for parsing a Json value
+     * */
+    struct ParseOptions {
+        // compute the content hashes of all containers while parsing
+        bool computeHashes = false;
+
+        // share one node between equal strings and between equal
+        // containers of up to maxSharedSize elements
+        bool deduplicate = false;
+        std::size_t maxSharedSize = 8;
+
+        // input nested deeper than this many containers is rejected
+        std::size_t maxDepth = 1024;
+
+        // where the whole document is allocated, nullptr for
+        // Memory::defaultResource()
+        std::pmr::memory_resource *resource = nullptr;
+
+        // store Arrays of nothing but integers, or of nothing but
+        // decimals, as contiguous vectors of numbers
+        bool packNumbers = true;
+    };
+
+
+    /**
+     * A container of Json values that also caches their content hash,
+     * 0 means the hash is not computed yet
+     * */
+    template<typename Container>
+    struct HashedContainer : public Container {
+        using Container::Container;
+
+        HashedContainer(const HashedContainer &other)
+            : Container(other), hash(other.hash.load(std::memory_order_relaxed))
+        {
+        }
+
+        HashedContainer(const HashedContainer &other, const typename Container::allocator_type &allocator)
+            : Container(other, allocator), hash(other.hash.load(std::memory_order_relaxed))
+        {
+        }
+
+        mutable std::atomic<std::uint64_t> hash{ 0 };
+    };
+
+
+    /**
+     * The container of an Array, which may hold its elements packed.
+     *
+     * A non-empty Array of integers that fit a long long, or of decimals
+     * that a double holds exactly, is kept as a contiguous vector of the
+     * numbers and the vector of Json values stays empty. The Json values
+     * are created from the numbers once something reads them through
+     * the vector, and unpacking for a modification drops the numbers.
+     * */
+    template<typename Container>
+    struct PackedContainer : public HashedContainer<Container> {
+        using allocator_type = typename Container::allocator_type;
+        using value_type = typename Container::value_type;
+        using Integers = std::pmr::vector<std::int64_t>;
+        using Doubles = std::pmr::vector<double>;
+
+        using HashedContainer<Container>::HashedContainer;
+
+        PackedContainer(const PackedContainer &other)
+            : HashedContainer<Container>(other), packed(copyPacked(other, this->get_allocator()))
+        {
+        }
+
+        PackedContainer(const PackedContainer &other, const allocator_type &allocator)
+            : HashedContainer<Container>(other, allocator), packed(copyPacked(other, allocator))
+        {
+        }
+
+        bool isPacked() const {
+            return packed.index() != 0;
+        }
+
+        // the number of elements, packed or not
+        std::size_t count() const {
+            switch (packed.index()) {
+                case 1: return std::get<1>(packed).size();
+                case 2: return std::get<2>(packed).size();
+                default: return this->size();
+            }
+        }
+
+        // one element by value, packed numbers are not unpacked for it
+        value_type element(std::size_t index) const {
+            switch (packed.index()) {
+                case 1: return value_type::fromPacked(std::get<1>(packed).at(index), this->get_allocator().resource());
+                case 2: return value_type::fromPacked(std::get<2>(packed).at(index), this->get_allocator().resource());
+                default: return this->at(index);
+            }
+        }
+
+        // the elements as Json values, created on the first call
+        const Container &materialized() const {
+            if (isPacked()) {
+                std::call_once(unpacking, [this]() {
+                    // the container itself is never const, only this view of it
+                    auto &elements = const_cast<Container &>(static_cast<const Container &>(*this));
+                    std::size_t size = count();
+
+                    // a copy of a materialized container has them already
+                    if (!elements.empty()) {
+                        return;
+                    }
+
+                    elements.reserve(size);
+
+                    for (std::size_t i = 0; i < size; ++i) {
+                        elements.push_back(element(i));
+                    }
+                });
+            }
+
+            return *this;
+        }
+
+        // turns the container into a plain vector of Json values for good
+        void unpack() {
+            if (isPacked()) {
+                materialized();
+                packed = std::monostate();
+            }
+        }
+
+        std::variant<std::monostate, Integers, Doubles> packed;
+
+        private:
+            static std::variant<std::monostate, Integers, Doubles> copyPacked(const PackedContainer &other, const allocator_type &allocator) {
+                switch (other.packed.index()) {
+                    case 1: return Integers(std::get<1>(other.packed), allocator);
+                    case 2: return Doubles(std::get<2>(other.packed), allocator);
+                    default: return std::monostate();
+                }
+            }
+
+            mutable std::once_flag unpacking;
+    };
+
+
+    /**
+     * A member name hashed once, for looking up the same names in many
+     * Objects.
+     *
+     * A Key only views its name, which must outlive it, and is meant to
+     * be made from a string literal at compile time:
+     *
+     *     static constexpr JSON::Key id{ "id" };
+     *     const Json *found = record.find(id);
+     * */
+    class Key {
+        public:
+            constexpr explicit Key(std::string_view name) noexcept : name(name), digest(hashOf(name)) {}
+            constexpr explicit Key(const char *name) noexcept : Key(std::string_view(name)) {}
+
+            constexpr std::string_view view() const noexcept { return name; }
+            constexpr std::size_t hash() const noexcept { return digest; }
+
+            /**
+             * This function hashes a member name the way the members of
+             * Objects are hashed, at compile time as well. The bytes are
+             * read one at a time, compilers merge them into 8-byte loads.
+             * */
+            static constexpr std::size_t hashOf(std::string_view name) noexcept {
+                constexpr std::uint64_t MULTIPLIER = 0x9E3779B97F4A7C15ULL;
+                constexpr std::uint64_t MIXER = 0xC2B2AE3D27D4EB4FULL;
+
+                std::uint64_t hash = name.size() * MULTIPLIER;
+
+                for (std::size_t pos = 0; pos < name.size(); pos += 8) {
+                    std::uint64_t word = 0;
+
+                    for (std::size_t i = 0; i < 8 && pos + i < name.size(); ++i) {
+                        word |= (std::uint64_t)(unsigned char)name[pos + i] << (8 * i);
+                    }
+
+                    hash = (hash ^ word) * MIXER;
+                    hash ^= hash >> 29;
+                }
+
+                hash ^= hash >> 32;
+                hash *= MULTIPLIER;
+                hash ^= hash >> 29;
+
+                return (std::size_t)hash;
+            }
+
+        private:
+            std::string_view name;
+            std::size_t digest;
+    };
+
+
+    /**
+     * Hash and equality of member names as string views, so that names
+     * of any string type are looked up without a conversion, and Keys
+     * without hashing them again
+     * */
+    struct KeyHash {
+        using is_transparent = void;
+
+        std::size_t operator()(std::string_view key) const noexcept {
+            return Key::hashOf(key);
+        }
+
+        std::size_t operator()(const Key &key) const noexcept {
+            return key.hash();
+        }
+    };
+
+    struct KeyEqual {
+        using is_transparent = void;
+
+        bool operator()(std::string_view left, std::string_view right) const noexcept {
+            return left == right;
+        }
+
+        bool operator()(const Key &left, std::string_view right) const noexcept {
+            return left.view() == right;
+        }
+
+        bool operator()(std::string_view left, const Key &right) const noexcept {
+            return left == right.view();
+        }
+    };
+
+
+    struct MemoryUsage;
+
+
     class Json {
         
         friend std::ostream &operator<<(std::ostream &output, const Json &json);
+        friend class Patcher;
+        friend class Interner;
+        friend class Parser;
+        template<typename> friend struct PackedContainer;
+        friend class Column;
+        friend class Table;
+        friend class Aggregator;
+        friend class Writer;
+        friend class Serializer;
+        friend class MemoryCounter;
+
+        // containers are reference counted and shared between copies,
+        // they are cloned on the first mutation through a shared handle.
+        // All nodes are allocated from a std::pmr::memory_resource, and
+        // a container keeps the resource of the node it was cloned from
+        using Text = std::pmr::string;
+        using Elements = PackedContainer<std::pmr::vector<Json>>;
+        using Members = HashedContainer<std::pmr::unordered_map<Text, Json, KeyHash, KeyEqual>>;
 
-        using JsonString = std::string *;
-        using JsonArray = std::vector<Json *> *;
-        using JsonObject = std::unordered_map<std::string, Json *> *;
+        using JsonString = std::shared_ptr<Text>;
+        using JsonArray = std::shared_ptr<Elements>;
+        using JsonObject = std::shared_ptr<Members>;
 
         public:
             enum Type {
@@ -39,13 +316,26 @@ namespace JSON {
         public:
             Json();
             Json(const Type &type);
+
+            /**
+             * This constructor creates an empty value of the given type
+             * whose storage comes from the given memory resource, which
+             * must outlive the value and every copy of it
+             * */
+            Json(const Type &type, std::pmr::memory_resource *resource);
             Json(const Json *other);
+            Json(const Json &other) = default;
+            Json(Json &&other) noexcept = default;
             ~Json();
 
             /**
              * This method returns a pointer to a Json value
              * extracted from the given std::string object
              * 
+             * The input must be a single RFC 8259 value, malformed input
+             * and input nested deeper than ParseOptions::maxDepth give an
+             * Invalid Json.
+             * 
              * @param[in] input
              *     The string object to be parsed.
              * 
@@ -53,18 +343,123 @@ namespace JSON {
              *     A pointer to the Json value which was parsed
              * */
             static Json *fromCppString(const std::string &input);
+            static Json *fromCppString(const std::string &input, const ParseOptions &options);
+
+            /**
+             * This method encodes the Json value into a compact binary
+             * form that can be turned back into a Json value with
+             * fromBinary() much faster than re-parsing the text
+             * 
+             * @return
+             *     The encoded bytes
+             * */
+            std::string toBinary() const;
+
+            /**
+             * This method returns a pointer to a Json value
+             * decoded from bytes produced by toBinary()
+             * 
+             * @param[in] data
+             *     Pointer to the encoded bytes.
+             * 
+             * @param[in] size
+             *     Number of encoded bytes.
+             * 
+             * @return
+             *     A pointer to the decoded Json value, the value is 
+             *     Invalid if the bytes are truncated or malformed
+             * */
+            static Json *fromBinary(const char *data, std::size_t size);
+
+            /**
+             * This method applies edits to the text a Json value was
+             * parsed from and updates the value to match, re-parsing only
+             * the smallest values that enclose each edit. Those values
+             * are replaced in place, every other node is left untouched.
+             * 
+             * @param[in,out] document
+             *     The Json value parsed from text.
+             * 
+             * @param[in,out] text
+             *     The text document was parsed from, the edits are
+             *     applied to it.
+             * 
+             * @param[in] edits
+             *     Non-overlapping edits, offsets refer to the text
+             *     before any of the edits is applied.
+             * 
+             * @return
+             *     false if the edits are out of range, overlap or make the
+             *     text malformed, in which case neither document nor text
+             *     are changed
+             * */
+            static bool reparse(Json &document, std::string &text, const std::vector<TextEdit> &edits);
+
+            /**
+             * This method returns a JSON Patch (RFC 6902) that turns one
+             * Json value into another. Scalars are compared by value, and
+             * Arrays and Objects that are the same node or have equal
+             * content hashes are skipped without being visited, so with
+             * cached hashes a diff costs as much as what changed.
+             * 
+             * Two different subtrees have equal 64-bit hashes with a
+             * chance of about 2^-64, a change in them would be missing
+             * from the patch.
+             * 
+             * @param[in] from
+             *     The original Json value.
+             * 
+             * @param[in] to
+             *     The modified Json value.
+             * 
+             * @param[in] confirmEqual
+             *     Compare subtrees with equal hashes before skipping
+             *     them, which rules out collisions at the cost of
+             *     visiting all unchanged content.
+             * 
+             * @return
+             *     An Array of operation Objects
+             * */
+            static Json diff(const Json &from, const Json &to, bool confirmEqual = false);
 
         private:
             Type type;
 
+            // Integer and FloatingPoint both hold a Number, they are told
+            // apart by the index of the alternative
             std::variant< 
                 bool, 
-                long long, 
-                long double, 
+                Number, 
+                Number, 
                 JsonString, 
                 JsonArray, 
                 JsonObject
             > value;
+
+            void detach();
+            bool equals(const Json &other) const;
+
+            // the member of an Object named by a string view or a Key
+            template<typename Name>
+            const Json *member(const Name &name) const;
+
+            // allocates a node and its control block from resource, the
+            // node itself allocates from it as well
+            template<typename Node, typename... Args>
+            static std::shared_ptr<Node> allocate(std::pmr::memory_resource *resource, Args &&...args) {
+                if (resource == nullptr) {
+                    resource = Memory::defaultResource();
+                }
+
+                return std::allocate_shared<Node>(std::pmr::polymorphic_allocator<Node>(resource), std::forward<Args>(args)...);
+            }
+
+            // an element of a packed Array
+            static Json fromPacked(std::int64_t integer, std::pmr::memory_resource *resource);
+            static Json fromPacked(double floatingPoint, std::pmr::memory_resource *resource);
+
+            void encodeBinary(std::string &output) const;
+            static bool decodeBinary(const char *&pos, const char *end, Json *json);
  
         public:
             static Json *parseBoolean(const std::string &input);
@@ -74,6 +469,9 @@ namespace JSON {
             static Json *parseString(const std::string &input);
             static Json *parseArray(const std::string &input);
             static Json *parseObject(const std::string &input);
+
+        private:
+            static Json *parseValue(const std::string &input);
         
         public:
             bool operator==(nullptr_t null) const;
@@ -88,6 +486,8 @@ namespace JSON {
             void operator=(long integer);
             bool operator==(long long integer) const;
             void operator=(long long integer);
+            bool operator==(unsigned long long integer) const;
+            void operator=(unsigned long long integer);
 
             bool operator==(float floatingPoint) const;
             void operator=(float floatingPoint);
@@ -103,14 +503,153 @@ namespace JSON {
 
             bool operator==(const Json &other) const;
             void operator=(const Json &other);
+            void operator=(Json &&other) noexcept;
             void operator=(const Json *other);
 
             Json operator[](int index) const;
             Json operator[](const char *key) const;
+            Json operator[](const Key &key) const;
+
+        public:
+            /**
+             * These methods return a reference to an element of an Array
+             * or a member of an Object which can be modified in place.
+             * 
+             * Copies of a Json value share their containers, so a
+             * container that is shared is cloned first, along with every
+             * container on the path used to reach it. Other copies never
+             * observe the modification.
+             * 
+             * @throw WrongTypeException
+             *     If the Json value is not an Array (or an Object).
+             * 
+             * Member names are looked up as string views without
+             * allocating, a Key is not hashed again.
+             *
+             * @throw std::out_of_range
+             *     If there is no such element (or member).
+             * */
+            Json &at(int index);
+            Json &at(std::string_view key);
+            Json &at(const Key &key);
+            const Json &at(int index) const;
+            const Json &at(std::string_view key) const;
+            const Json &at(const Key &key) const;
+
+            /**
+             * These methods look a member up without throwing, for
+             * Objects where most names are missing
+             *
+             * @return
+             *     The member, nullptr if there is none or the Json value
+             *     is not an Object
+             * */
+            const Json *find(std::string_view key) const;
+            const Json *find(const Key &key) const;
+
+            bool contains(std::string_view key) const { return find(key) != nullptr; }
+            bool contains(const Key &key) const { return find(key) != nullptr; }
+
+            void append(const Json &element);
+            void insert(int index, const Json &element);
+            void insert(const std::string &key, const Json &member);
+            void erase(int index);
+            void erase(const std::string &key);
+
+            /**
+             * This method returns the number of elements of an Array,
+             * the number of members of an Object or the length of a String
+             * */
+            std::size_t size() const;
+
+            /**
+             * This method walks the Json value and adds up the bytes that
+             * its nodes retain, see MemoryUsage. The bytes of a document
+             * parsed into an arena are Parser::getArena().used().
+             * */
+            MemoryUsage memoryUsage() const;
+
+            /**
+             * This method returns a 64-bit hash of the content of the Json
+             * value. The hashes of Arrays and Objects are computed bottom-up
+             * and cached in the container, a container modified through
+             * at(), append(), insert() or erase() drops its cached hash.
+             * 
+             * A reference returned by at() does not invalidate the hashes
+             * of its ancestors when it is modified later, call at() again
+             * from the root before modifying a node after hashing.
+             * */
+            std::uint64_t hash() const;
+
+            /**
+             * This method makes equal strings, and equal Arrays and
+             * Objects of up to maxSharedSize elements, inside the Json value
+             * share a single node. Shared nodes are cloned again when they
+             * are modified through one of their parents.
+             * 
+             * @param[in] maxSharedSize
+             *     Larger containers are never shared, their children are.
+             * */
+            void deduplicate(std::size_t maxSharedSize = 8);
+
+        public:
+            /**
+             * This method applies a JSON Patch (RFC 6902) to the Json value
+             * in place. Operations with paths that share a prefix reuse the
+             * containers resolved for the previous operation.
+             * 
+             * @param[in] patch
+             *     An Array of operation Objects.
+             * 
+             * @param[out] inverse
+             *     If not nullptr, receives a JSON Patch that undoes the
+             *     applied one.
+             * 
+             * @return
+             *     false if an operation is malformed, its path does not
+             *     exist or a "test" operation fails, in which case the
+             *     Json value is left unchanged
+             * */
+            bool applyPatch(const Json &patch, Json *inverse = nullptr);
+
+            /**
+             * This method applies a JSON Merge Patch (RFC 7396) to the
+             * Json value in place
+             * 
+             * @param[in] patch
+             *     The merge patch.
+             * 
+             * @param[out] inverse
+             *     If not nullptr, receives a JSON Patch (RFC 6902) that
+             *     undoes the applied merge patch.
+             * */
+            void applyMergePatch(const Json &patch, Json *inverse = nullptr);
         
         public:
             Type getType() const;
 
+            /**
+             * This method returns the number held by an Integer or a
+             * FloatingPoint, with the digits it was parsed from
+             * 
+             * @throw WrongTypeException
+             *     If the Json value is not a number.
+             * */
+            const Number &getNumber() const;
+
+            /**
+             * These methods return the numbers of a packed Array as one
+             * contiguous span, so loops over them can be vectorized. The
+             * span is valid until the Array is modified.
+             * 
+             * @throw WrongTypeException
+             *     If the Json value is not an Array packed with numbers
+             *     of that kind.
+             * */
+            bool isPacked() const;
+            std::span<const std::int64_t> integers() const;
+            std::span<const double> doubles() const;
+
             bool isInvalid() const { return type == Type::Invalid; }
             bool isNull() const { return type == Type::Null; }
             bool isBoolean() const { return type == Type::Boolean; }
@@ -120,10 +659,14 @@ namespace JSON {
             bool isArray() const { return type == Type::Array; }
             bool isObject() const { return type == Type::Object; }
 
+            // numbers are converted from their digits on the first read,
+            // integers that do not fit throw std::out_of_range and any
+            // integer can be read as floating point
             operator bool();
             operator int();
             operator long();
             operator long long();
+            operator unsigned long long();
             operator float();
             operator double();
             operator long double();
@@ -132,4 +675,129 @@ namespace JSON {
 
     std::ostream &operator<<(std::ostream &output, const Json &json);
 
+    /**
+     * The result of Json::memoryUsage(), the bytes a Json value retains
+     * for each Json::Type, by the nodes of that type they belong to.
+     *
+     * Nodes reached more than once, through deduplication or copies, are
+     * counted once. Control blocks and map nodes are counted at the size
+     * of the standard library's layout, what the memory resource adds
+     * to each allocation is not counted.
+     * */
+    struct MemoryUsage {
+        struct Bytes {
+            // how many values of the type there are
+            std::size_t values = 0;
+
+            // Json handles, the nodes they point to and the control
+            // blocks of those, strings that fit inline included
+            std::size_t nodes = 0;
+
+            // characters and digits on the heap, and packed numbers
+            std::size_t payload = 0;
+
+            // capacity of strings and vectors that is not in use
+            std::size_t slack = 0;
+
+            // bucket arrays and member nodes of Objects
+            std::size_t hashing = 0;
+
+            std::size_t total() const { return nodes + payload + slack + hashing; }
+        };
+
+        Bytes types[Json::Type::Invalid + 1];
+
+        // references to nodes that were counted before
+        std::size_t shared = 0;
+
+        const Bytes &operator[](Json::Type type) const { return types[type]; }
+
+        std::size_t total() const {
+            std::size_t sum = 0;
+
+            for (const Bytes &bytes : types) {
+                sum += bytes.total();
+            }
+
+            return sum;
+        }
+    };
+
+    /**
+     * The result of validate()
+     * */
+    struct Validation {
+        bool valid;
+
+        // offset of the first byte that breaks the grammar,
+        // the size of the input if it ends too early
+        std::size_t errorOffset;
+
+        explicit operator bool() const { return valid; }
+    };
+
+    /**
+     * This function checks that the input is a single well-formed JSON
+     * value according to RFC 8259, including the validity of escapes and
+     * of UTF-8, without building a Json value and without allocating.
+     * 
+     * Nesting deeper than MAX_VALIDATION_DEPTH levels is reported as an
+     * error at the bracket that exceeds it.
+     * 
+     * @param[in] data
+     *     Pointer to the text to be checked.
+     * 
+     * @param[in] size
+     *     Number of bytes to be checked.
+     * 
+     * @return
+     *     Whether the input is valid, and where the first error is
+     * */
+    Validation validate(const char *data, std::size_t size);
+
+    constexpr std::size_t MAX_VALIDATION_DEPTH = 4096;
+
+    /**
+     * A source of input in chunks: copies up to `capacity` bytes into
+     * `buffer` and returns how many it copied, 0 at the end of input
+     * and READ_FAILED where the input turns out to be broken
+     * */
+    using ChunkReader = std::function<std::size_t(char *buffer, std::size_t capacity)>;
+
+    constexpr std::size_t READ_FAILED = (std::size_t)-1;
+
+    /**
+     * This function iterates over the elements of a top-level Array,
+     * parsing each one only when the loop asks for it
+     *
+     *     for (auto &element : JSON::elements(text)) { ... }
+     *
+     * If the input is not an Array or is malformed, the last element
+     * yielded is an Invalid Json and the iteration stops there.
+     *
+     * @param[in] text
+     *     The whole document, which must outlive the loop.
+     * */
+    Generator<Json> elements(std::string_view text);
+
+    /**
+     * This function iterates over the elements of a top-level Array
+     * read in chunks. Only the element being parsed is held in memory,
+     * and input is read as the loop advances.
+     *
+     * @param[in] reader
+     *     The source of the input.
+     *
+     * @param[in] chunkSize
+     *     The number of bytes asked for in each read, reads grow beyond
+     *     it while a single element does not fit.
+     * */
+    Generator<Json> elements(ChunkReader reader, std::size_t chunkSize = 64 * 1024);
+
+    /**
+     * This function iterates over the elements of a top-level Array
+     * read from a stream
+     * */
+    Generator<Json> elements(std::istream &input, std::size_t chunkSize = 64 * 1024);
+
 }; // namespace JSON
@@ -0,0 +1,216 @@
+#include <atomic>
+#include <unordered_set>
+#include <vector>
+
+#include "json.hpp"
+#include "memory.hpp"
+
+namespace JSON {
+
+    namespace {
+
+        // a thread publishes its count once it is this far off
+        constexpr std::ptrdiff_t PUBLISH_BYTES = 64 * 1024;
+
+        // the vtable pointer and the two counts of a shared_ptr control
+        // block, and the allocator it keeps
+        constexpr std::size_t CONTROL_BLOCK_SIZE = 2 * sizeof(void *) + sizeof(std::pmr::polymorphic_allocator<char>);
+
+        std::atomic<std::ptrdiff_t> published{ 0 };
+
+        // what the thread counted since it last published
+        struct Unpublished {
+            std::ptrdiff_t bytes = 0;
+
+            ~Unpublished() {
+                published.fetch_add(bytes, std::memory_order_relaxed);
+            }
+        };
+
+        thread_local Unpublished unpublished;
+
+        class CountingResource : public std::pmr::memory_resource {
+            public:
+                explicit CountingResource(std::pmr::memory_resource *upstream) : upstream(upstream) {}
+
+                std::pmr::memory_resource *getUpstream() const { return upstream; }
+
+            protected:
+                void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+                    void *pointer = upstream->allocate(bytes, alignment);
+                    Memory::account((std::ptrdiff_t)bytes);
+
+                    return pointer;
+                }
+
+                void do_deallocate(void *pointer, std::size_t bytes, std::size_t alignment) override {
+                    upstream->deallocate(pointer, bytes, alignment);
+                    Memory::account(-(std::ptrdiff_t)bytes);
+                }
+
+                bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+                    return this == &other;
+                }
+
+            private:
+                std::pmr::memory_resource *upstream;
+        };
+    };
+
+    namespace Memory {
+
+        std::pmr::memory_resource *defaultResource() {
+            // never destroyed, values in static storage may outlive any
+            // other object
+            static CountingResource *counting = new CountingResource(std::pmr::get_default_resource());
+            std::pmr::memory_resource *current = std::pmr::get_default_resource();
+
+            // values made before a new default was set still free their
+            // memory through the counting resource
+            return current == counting->getUpstream() ? counting : current;
+        }
+
+        std::size_t liveBytes() {
+            std::ptrdiff_t bytes = published.load(std::memory_order_relaxed) + unpublished.bytes;
+            return bytes < 0 ? 0 : (std::size_t)bytes;
+        }
+
+        void account(std::ptrdiff_t bytes) {
+            Unpublished &local = unpublished;
+            local.bytes += bytes;
+
+            if (local.bytes >= PUBLISH_BYTES || local.bytes <= -PUBLISH_BYTES) {
+                published.fetch_add(local.bytes, std::memory_order_relaxed);
+                local.bytes = 0;
+            }
+        }
+    };
+
+    /**
+     * Walks a Json value without recursion and adds the bytes of every
+     * node it reaches for the first time to a MemoryUsage
+     * */
+    class MemoryCounter {
+        public:
+            explicit MemoryCounter(MemoryUsage &usage) : usage(usage) {}
+
+            void count(const Json &root) {
+                std::vector<const Json *> pending{ &root };
+
+                while (!pending.empty()) {
+                    const Json &json = *pending.back();
+                    pending.pop_back();
+
+                    MemoryUsage::Bytes &bytes = usage.types[json.type];
+                    ++bytes.values;
+                    bytes.nodes += sizeof(Json);
+
+                    switch (json.type) {
+                        case Json::Type::Integer:
+                        case Json::Type::FloatingPoint: {
+                            const Number &number = (json.type == Json::Type::Integer) ?
+                                std::get<Json::Type::Integer>(json.value) : std::get<Json::Type::FloatingPoint>(json.value);
+
+                            // digits that do not fit inline have a node of their own
+                            if ((number.state & Number::EXTERNAL) && first(number.external().get())) {
+                                bytes.nodes += CONTROL_BLOCK_SIZE + sizeof(std::pmr::string);
+                                addString(bytes, *number.external());
+                            }
+                        } break;
+
+                        case Json::Type::String: {
+                            const auto &string = std::get<Json::Type::String>(json.value);
+
+                            if (first(string.get())) {
+                                bytes.nodes += CONTROL_BLOCK_SIZE + sizeof(Json::Text);
+                                addString(bytes, *string);
+                            }
+                        } break;
+
+                        case Json::Type::Array: {
+                            const auto &elements = *std::get<Json::Type::Array>(json.value);
+
+                            if (!first(&elements)) {
+                                break;
+                            }
+
+                            bytes.nodes += CONTROL_BLOCK_SIZE + sizeof(Json::Elements);
+
+                            // the handles of the elements count as their nodes
+                            bytes.slack += (elements.capacity() - elements.size()) * sizeof(Json);
+
+                            switch (elements.packed.index()) {
+                                case 1: addVector(bytes, std::get<1>(elements.packed)); break;
+                                case 2: addVector(bytes, std::get<2>(elements.packed)); break;
+                                default: break;
+                            }
+
+                            // packed Arrays have Json values only once they are read as such
+                            for (const Json &element : static_cast<const std::pmr::vector<Json> &>(elements)) {
+                                pending.push_back(&element);
+                            }
+                        } break;
+
+                        case Json::Type::Object: {
+                            const auto &members = *std::get<Json::Type::Object>(json.value);
+
+                            if (!first(&members)) {
+                                break;
+                            }
+
+                            // a map node holds the next pointer, the name and the
+                            // value, whose handle counts as the node of the value
+                            bytes.nodes += CONTROL_BLOCK_SIZE + sizeof(Json::Members);
+                            bytes.hashing += members.bucket_count() * sizeof(void *) + members.size() * (sizeof(void *) + sizeof(Json::Text));
+
+                            for (const auto &member : members) {
+                                addString(bytes, member.first);
+                                pending.push_back(&member.second);
+                            }
+                        } break;
+
+                        default: break;
+                    }
+                }
+            }
+
+        private:
+            bool first(const void *node) {
+                if (visited.insert(node).second) {
+                    return true;
+                }
+
+                ++usage.shared;
+
+                return false;
+            }
+
+            // only characters on the heap, the others are part of the node
+            void addString(MemoryUsage::Bytes &bytes, const std::pmr::string &string) {
+                if (string.capacity() > INLINE_CAPACITY) {
+                    bytes.payload += string.size();
+                    bytes.slack += string.capacity() + 1 - string.size();
+                }
+            }
+
+            template<typename Vector>
+            void addVector(MemoryUsage::Bytes &bytes, const Vector &vector) {
+                bytes.payload += vector.size() * sizeof(typename Vector::value_type);
+                bytes.slack += (vector.capacity() - vector.size()) * sizeof(typename Vector::value_type);
+            }
+
+        private:
+            inline static const std::size_t INLINE_CAPACITY = std::pmr::string().capacity();
+
+            MemoryUsage &usage;
+            std::unordered_set<const void *> visited;
+    };
+
+    MemoryUsage Json::memoryUsage() const {
+        MemoryUsage usage;
+        MemoryCounter(usage).count(*this);
+
+        return usage;
+    }
+
+}; // namespace JSON
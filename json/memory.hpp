@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+namespace JSON {
+
+    /**
+     * A process-wide gauge of the bytes held by Json values.
+     *
+     * Values made without a memory resource of their own allocate from
+     * defaultResource(), which counts what it hands out and forwards to
+     * the default resource of the process. Arenas count the blocks they
+     * keep. Each thread adds up its own count and publishes it every
+     * 64 KiB, so the gauge is exact for the calling thread and within
+     * 64 KiB for every other one.
+     * */
+    namespace Memory {
+
+        /**
+         * This function returns the resource Json values use when none
+         * is given: a counting resource over std::pmr::get_default_resource(),
+         * or that resource as it is if it was replaced after the first use
+         * */
+        std::pmr::memory_resource *defaultResource();
+
+        // the bytes held right now by all counted resources
+        std::size_t liveBytes();
+
+        // counts bytes taken from, or given back to, the system by a
+        // resource of the library, negative when they are given back
+        void account(std::ptrdiff_t bytes);
+    };
+};
@@ -0,0 +1,220 @@
+#include "hash.hpp"
+#include "json.hpp"
+
+namespace JSON {
+
+    namespace {
+
+        std::uint64_t combine(std::uint64_t seed, std::uint64_t a, std::uint64_t b) {
+            std::uint64_t words[2] = { a, b };
+            return Hash::xxh64(words, sizeof(words), seed);
+        }
+
+        std::uint64_t hashInteger(long long integer) {
+            return Hash::xxh64(&integer, sizeof(integer), Json::Type::Integer);
+        }
+
+        // 0.0 and -0.0 hash alike since they compare equal
+        std::uint64_t hashDouble(double floatingPoint) {
+            if (floatingPoint == 0.0) {
+                floatingPoint = 0.0;
+            }
+
+            return Hash::xxh64(&floatingPoint, sizeof(floatingPoint), Json::Type::FloatingPoint);
+        }
+    };
+
+    std::uint64_t Json::hash() const {
+        // the type is the seed, so equal bytes of different types differ
+        std::uint64_t seed = (std::uint64_t)type;
+        std::uint64_t result = 0;
+
+        switch (type) {
+            case Type::Invalid:
+            case Type::Null: {
+                result = Hash::xxh64(nullptr, 0, seed);
+            } break;
+
+            case Type::Boolean: {
+                bool boolean = std::get<Type::Boolean>(value);
+                result = Hash::xxh64(&boolean, sizeof(boolean), seed);
+            } break;
+
+            case Type::Integer: {
+                const Number &number = std::get<Type::Integer>(value);
+
+                // the classes never overlap, so neither do their hashes
+                if (number.getClass() == Number::Class::Big) {
+                    std::string_view digits = number.text();
+                    result = Hash::xxh64(digits.data(), digits.size(), seed);
+                } else if (number.getClass() == Number::Class::UInt64) {
+                    unsigned long long integer = number.toUInt64();
+                    result = Hash::xxh64(&integer, sizeof(integer), seed);
+                } else {
+                    result = hashInteger(number.toInt64());
+                }
+            } break;
+
+            case Type::FloatingPoint: {
+                // compared as doubles, so hashed as doubles
+                result = hashDouble(std::get<Type::FloatingPoint>(value).toDouble());
+            } break;
+
+            case Type::String: {
+                const Text &string = *(std::get<Type::String>(value));
+                result = Hash::xxh64(string.data(), string.size(), seed);
+            } break;
+
+            case Type::Array: {
+                const Elements &elements = *(std::get<Type::Array>(value));
+                result = elements.hash.load(std::memory_order_relaxed);
+
+                if (result != 0) {
+                    return result;
+                }
+
+                result = combine(seed, elements.count(), 0);
+
+                // packed numbers hash like the Json values they stand for
+                if (const auto *integers = std::get_if<Elements::Integers>(&elements.packed)) {
+                    for (std::int64_t integer : *integers) {
+                        result = combine(seed, result, hashInteger(integer));
+                    }
+                } else if (const auto *doubles = std::get_if<Elements::Doubles>(&elements.packed)) {
+                    for (double floatingPoint : *doubles) {
+                        result = combine(seed, result, hashDouble(floatingPoint));
+                    }
+                } else {
+                    for (const auto &element : elements) {
+                        result = combine(seed, result, element.hash());
+                    }
+                }
+
+                // 0 marks a hash that is not computed
+                result += (result == 0);
+                elements.hash.store(result, std::memory_order_relaxed);
+            } break;
+
+            case Type::Object: {
+                const Members &members = *(std::get<Type::Object>(value));
+                result = members.hash.load(std::memory_order_relaxed);
+
+                if (result != 0) {
+                    return result;
+                }
+
+                // members are unordered, so their hashes are summed
+                std::uint64_t sum = 0;
+
+                for (const auto &member : members) {
+                    std::uint64_t key = Hash::xxh64(member.first.data(), member.first.size());
+                    sum += combine(seed, key, member.second.hash());
+                }
+
+                result = combine(seed, members.size(), sum);
+                result += (result == 0);
+                members.hash.store(result, std::memory_order_relaxed);
+            } break;
+        }
+
+        return result;
+    }
+
+    bool Json::operator==(const Json &other) const {
+        if (type != other.type) {
+            return false;
+        }
+
+        // a hash mismatch proves the values differ, a match still has to
+        // be confirmed in case of a collision
+        if ((type == Type::Array || type == Type::Object) && hash() != other.hash()) {
+            return false;
+        }
+
+        return equals(other);
+    }
+
+    bool Json::equals(const Json &other) const {
+        if (type != other.type) {
+            return false;
+        }
+
+        switch (type) {
+            case Type::Invalid:
+            case Type::Null: {
+                return true;
+            }
+
+            case Type::String: {
+                const auto &left = std::get<Type::String>(value);
+                const auto &right = std::get<Type::String>(other.value);
+
+                return left == right || *left == *right;
+            }
+
+            case Type::Array: {
+                const auto &left = std::get<Type::Array>(value);
+                const auto &right = std::get<Type::Array>(other.value);
+
+                // shared subtrees are equal without looking inside
+                if (left == right) {
+                    return true;
+                }
+
+                if (left->count() != right->count()) {
+                    return false;
+                }
+
+                if (left->isPacked() || right->isPacked()) {
+                    if (left->packed.index() == right->packed.index()) {
+                        return left->packed == right->packed;
+                    }
+
+                    for (std::size_t i = 0; i < left->count(); ++i) {
+                        if (!left->element(i).equals(right->element(i))) {
+                            return false;
+                        }
+                    }
+
+                    return true;
+                }
+
+                for (std::size_t i = 0; i < left->size(); ++i) {
+                    if (!(*left)[i].equals((*right)[i])) {
+                        return false;
+                    }
+                }
+
+                return true;
+            }
+
+            case Type::Object: {
+                const auto &left = std::get<Type::Object>(value);
+                const auto &right = std::get<Type::Object>(other.value);
+
+                if (left == right) {
+                    return true;
+                }
+
+                if (left->size() != right->size()) {
+                    return false;
+                }
+
+                for (const auto &member : *left) {
+                    auto found = right->find(member.first);
+
+                    if (found == right->end() || !member.second.equals(found->second)) {
+                        return false;
+                    }
+                }
+
+                return true;
+            }
+
+            default: {
+                return value == other.value;
+            }
+        }
+    }
+
+}; // namespace JSON
@@ -0,0 +1,264 @@
+#include <bit>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <stdexcept>
+
+#include "memory.hpp"
+#include "number.hpp"
+
+namespace JSON {
+
+    namespace {
+
+        /**
+         * Finds the class of a number from its digits, which follow
+         * the RFC 8259 grammar so they have no leading zeros
+         * */
+        Number::Class classify(std::string_view text) {
+            if (text.find_first_of(".eE") != std::string_view::npos) {
+                return Number::Class::Double;
+            }
+
+            bool negative = (text.front() == '-');
+            std::string_view digits = text.substr(negative ? 1 : 0);
+
+            // digit strings of equal length compare like the numbers they spell
+            auto fits = [&digits](std::string_view limit) {
+                return digits.size() < limit.size() || (digits.size() == limit.size() && digits <= limit);
+            };
+
+            if (negative) {
+                return fits("9223372036854775808") ? Number::Class::Int64 : Number::Class::Big;
+            }
+
+            if (fits("9223372036854775807")) {
+                return Number::Class::Int64;
+            }
+
+            return fits("18446744073709551615") ? Number::Class::UInt64 : Number::Class::Big;
+        }
+
+        template<typename T>
+        T parseIntegral(std::string_view text) {
+            T number = 0;
+            std::from_chars(text.data(), text.data() + text.size(), number);
+
+            return number;
+        }
+
+        template<typename T>
+        T parseFloatingPoint(std::string_view text) {
+            T number = 0;
+
+            if (std::from_chars(text.data(), text.data() + text.size(), number).ec != std::errc()) {
+                // out of range, let strtold round to infinity or zero
+                number = (T)std::strtold(std::string(text).c_str(), nullptr);
+            }
+
+            return number;
+        }
+    };
+
+    Number::Number(long long integer)
+        : bits((std::uint64_t)integer), storage(), length(0), state(Class::Int64 | CONVERTED)
+    {
+    }
+
+    Number::Number(unsigned long long integer)
+        : bits(integer), storage(), length(0), state(CONVERTED)
+    {
+        state |= (integer <= (unsigned long long)std::numeric_limits<long long>::max()) ? Class::Int64 : Class::UInt64;
+    }
+
+    Number::Number(long double floatingPoint)
+        : bits(std::bit_cast<std::uint64_t>((double)floatingPoint)), storage(), length(0), state(Class::Double | CONVERTED | PRECISE)
+    {
+        std::memcpy(storage, &floatingPoint, sizeof(floatingPoint));
+    }
+
+    Number::Number(std::string_view text, std::pmr::memory_resource *resource)
+        : bits(0), length(0), state(classify(text))
+    {
+        if (text.size() <= INLINE_SIZE) {
+            std::memcpy(storage, text.data(), text.size());
+            length = (std::uint8_t)text.size();
+            return;
+        }
+
+        if (resource == nullptr) {
+            resource = Memory::defaultResource();
+        }
+
+        new (storage) Digits(std::allocate_shared<std::pmr::string>(std::pmr::polymorphic_allocator<std::pmr::string>(resource), text));
+        state |= EXTERNAL;
+    }
+
+    Number::Number(const Number &other) {
+        copy(other);
+    }
+
+    Number::Number(Number &&other) noexcept {
+        take(other);
+    }
+
+    Number &Number::operator=(const Number &other) {
+        if (this != &other) {
+            release();
+            copy(other);
+        }
+
+        return *this;
+    }
+
+    Number &Number::operator=(Number &&other) noexcept {
+        if (this != &other) {
+            release();
+            take(other);
+        }
+
+        return *this;
+    }
+
+    Number::~Number() {
+        release();
+    }
+
+    void Number::copy(const Number &other) {
+        bits = other.bits;
+        length = other.length;
+        state = other.state;
+
+        if (state & EXTERNAL) {
+            new (storage) Digits(other.external());
+        } else {
+            std::memcpy(storage, other.storage, INLINE_SIZE);
+        }
+    }
+
+    void Number::take(Number &other) noexcept {
+        bits = other.bits;
+        length = other.length;
+        state = other.state;
+
+        if (state & EXTERNAL) {
+            new (storage) Digits(std::move(other.external()));
+        } else {
+            std::memcpy(storage, other.storage, INLINE_SIZE);
+        }
+    }
+
+    void Number::release() {
+        if (state & EXTERNAL) {
+            external().~Digits();
+            state &= ~EXTERNAL;
+        }
+    }
+
+    std::string_view Number::text() const {
+        if (state & EXTERNAL) {
+            return *external();
+        }
+
+        return std::string_view((const char *)storage, length);
+    }
+
+    void Number::convert() {
+        if (state & CONVERTED) {
+            return;
+        }
+
+        switch (getClass()) {
+            case Class::Int64: {
+                bits = (std::uint64_t)parseIntegral<long long>(text());
+            } break;
+
+            case Class::UInt64: {
+                bits = parseIntegral<unsigned long long>(text());
+            } break;
+
+            case Class::Double:
+            case Class::Big: {
+                bits = std::bit_cast<std::uint64_t>(parseFloatingPoint<double>(text()));
+            } break;
+        }
+
+        state |= CONVERTED;
+    }
+
+    long long Number::toInt64() const {
+        if (getClass() != Class::Int64) {
+            throw std::out_of_range("Number::toInt64: the number does not fit a long long");
+        }
+
+        return (state & CONVERTED) ? (long long)bits : parseIntegral<long long>(text());
+    }
+
+    unsigned long long Number::toUInt64() const {
+        switch (getClass()) {
+            case Class::Int64: {
+                long long integer = toInt64();
+
+                if (integer >= 0) {
+                    return (unsigned long long)integer;
+                }
+            } break;
+
+            case Class::UInt64: {
+                return (state & CONVERTED) ? bits : parseIntegral<unsigned long long>(text());
+            }
+
+            default: break;
+        }
+
+        throw std::out_of_range("Number::toUInt64: the number does not fit an unsigned long long");
+    }
+
+    double Number::toDouble() const {
+        switch (getClass()) {
+            case Class::Int64: return (double)toInt64();
+            case Class::UInt64: return (double)toUInt64();
+
+            default: {
+                return (state & CONVERTED) ? std::bit_cast<double>(bits) : parseFloatingPoint<double>(text());
+            }
+        }
+    }
+
+    long double Number::toLongDouble() const {
+        if (state & PRECISE) {
+            long double floatingPoint;
+            std::memcpy(&floatingPoint, storage, sizeof(floatingPoint));
+
+            return floatingPoint;
+        }
+
+        switch (getClass()) {
+            case Class::Int64: return (long double)toInt64();
+            case Class::UInt64: return (long double)toUInt64();
+
+            // only a double is cached, the digits give the full precision
+            default: return parseFloatingPoint<long double>(text());
+        }
+    }
+
+    bool Number::operator==(const Number &other) const {
+        if (getClass() != other.getClass()) {
+            return false;
+        }
+
+        switch (getClass()) {
+            case Class::Int64: return toInt64() == other.toInt64();
+            case Class::UInt64: return toUInt64() == other.toUInt64();
+
+            // without leading zeros equal integers have equal digits
+            case Class::Big: return text() == other.text();
+
+            // like their hashes, decimals compare as doubles
+            default: return toDouble() == other.toDouble();
+        }
+    }
+
+}; // namespace JSON
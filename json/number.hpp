@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+namespace JSON {
+
+    /**
+     * A JSON number that keeps the text it was parsed from.
+     *
+     * The parser only records the digits and the class of the number,
+     * they are converted to a C++ number when the value is read, and
+     * convert() keeps the 64-bit result for later reads. A long double
+     * is never kept, there is no room for one beside the digits, so
+     * toLongDouble() parses them every time. The digits are written
+     * back verbatim, so integers beyond 64 bits and decimals beyond
+     * double precision round-trip exactly. Numbers assigned from C++
+     * have no digits.
+     * */
+    class Number {
+        friend class MemoryCounter;
+
+        public:
+            enum Class : std::uint8_t {
+                Int64,      // fits a long long
+                UInt64,     // fits an unsigned long long only
+                Double,     // has a fraction or an exponent
+                Big         // an integer that fits neither
+            };
+
+            Number() : Number(0LL) {}
+            explicit Number(long long integer);
+            explicit Number(unsigned long long integer);
+            explicit Number(long double floatingPoint);
+
+            /**
+             * This constructor records the digits of a number that
+             * matches the RFC 8259 grammar
+             *
+             * @param[in] resource
+             *     Where digits that do not fit inline are allocated,
+             *     nullptr for Memory::defaultResource().
+             * */
+            Number(std::string_view text, std::pmr::memory_resource *resource);
+
+            Number(const Number &other);
+            Number(Number &&other) noexcept;
+            Number &operator=(const Number &other);
+            Number &operator=(Number &&other) noexcept;
+            ~Number();
+
+            Class getClass() const { return (Class)(state & CLASS_MASK); }
+            bool isIntegral() const { return getClass() != Class::Double; }
+
+            // the digits as they were parsed, empty if set from C++
+            std::string_view text() const;
+
+            // converts the digits now so later reads are free
+            void convert();
+
+            /**
+             * These methods return the value as a C++ number, converting
+             * the digits unless convert() was called before, except for
+             * toLongDouble() which always converts them
+             *
+             * @throw std::out_of_range
+             *     If an integer does not fit the requested type.
+             * */
+            long long toInt64() const;
+            unsigned long long toUInt64() const;
+            double toDouble() const;
+            long double toLongDouble() const;
+
+            bool operator==(const Number &other) const;
+
+        private:
+            using Digits = std::shared_ptr<std::pmr::string>;
+
+            // the bits of state above the Class
+            static constexpr std::uint8_t CLASS_MASK = 0x03;
+            static constexpr std::uint8_t CONVERTED = 0x04;    // bits holds the value
+            static constexpr std::uint8_t EXTERNAL = 0x08;     // storage holds Digits instead of the digits
+            static constexpr std::uint8_t PRECISE = 0x10;      // storage holds a long double set from C++
+
+            // fits every 64-bit integer and most decimals
+            static constexpr std::size_t INLINE_SIZE = 22;
+
+            Digits &external() { return *reinterpret_cast<Digits *>(storage); }
+            const Digits &external() const { return *reinterpret_cast<const Digits *>(storage); }
+
+            void copy(const Number &other);
+            void take(Number &other) noexcept;
+            void release();
+
+        private:
+            std::uint64_t bits;
+            alignas(Digits) unsigned char storage[INLINE_SIZE];
+            std::uint8_t length;
+            std::uint8_t state;
+    };
+
+}; // namespace JSON
@@ -0,0 +1,466 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "offsets.hpp"
+#include "parser.hpp"
+#include "scanner.hpp"
+
+namespace fs = std::filesystem;
+
+namespace JSON {
+
+    namespace {
+
+        // sidecar layout: magic, size and modification time of the file,
+        // element count and offsets, key field, key count and the keys
+        // with their elements, all integers are 64 bits
+        constexpr char MAGIC[8] = { 'J', 'S', 'O', 'N', 'I', 'D', 'X', '1' };
+
+        void putInteger(std::string &output, std::uint64_t integer) {
+            char bytes[sizeof(integer)];
+            std::memcpy(bytes, &integer, sizeof(integer));
+            output.append(bytes, sizeof(bytes));
+        }
+
+        void putString(std::string &output, std::string_view string) {
+            putInteger(output, string.size());
+            output.append(string);
+        }
+
+        // reads the sidecar back, every read checks that the bytes are there
+        class SidecarReader {
+            public:
+                explicit SidecarReader(std::string_view input) : input(input), pos(0) {}
+
+                bool integer(std::uint64_t &integer) {
+                    if (input.size() - pos < sizeof(integer)) {
+                        return false;
+                    }
+
+                    std::memcpy(&integer, input.data() + pos, sizeof(integer));
+                    pos += sizeof(integer);
+
+                    return true;
+                }
+
+                bool string(std::string &string) {
+                    std::uint64_t size = 0;
+
+                    if (!integer(size) || input.size() - pos < size) {
+                        return false;
+                    }
+
+                    string.assign(input.data() + pos, (std::size_t)size);
+                    pos += (std::size_t)size;
+
+                    return true;
+                }
+
+                bool finished() const { return pos == input.size(); }
+
+            private:
+                std::string_view input;
+                std::size_t pos;
+        };
+
+        std::int64_t modificationTime(const fs::path &file, std::error_code &error) {
+            return (std::int64_t)fs::last_write_time(file, error).time_since_epoch().count();
+        }
+
+        /**
+         * Maps a whole file for reading
+         *
+         * @return
+         *     The bytes, nullptr if the file is empty or can not be mapped
+         * */
+        const char *mapFile(const fs::path &file, std::size_t &length, int advice) {
+            int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+
+            if (fd < 0) {
+                return nullptr;
+            }
+
+            struct stat status;
+            void *mapped = MAP_FAILED;
+
+            if (::fstat(fd, &status) == 0 && status.st_size > 0) {
+                length = (std::size_t)status.st_size;
+                mapped = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            }
+
+            // the mapping keeps the file open
+            ::close(fd);
+
+            if (mapped == MAP_FAILED) {
+                return nullptr;
+            }
+
+            ::madvise(mapped, length, advice);
+
+            return (const char *)mapped;
+        }
+
+        /**
+         * Finds the value of a member in the text of an Object, without
+         * building it
+         *
+         * @param[out] key
+         *     The content of a string value, or the text of another scalar.
+         *
+         * @return
+         *     false if the Object has no such member, its value is a
+         *     container, or the text is malformed
+         * */
+        bool memberKey(const char *pos, const char *end, std::string_view field, std::string &name, std::string &key) {
+            const char *error = nullptr;
+            pos = Scanner::skipWhitespace(pos + 1, end);
+
+            while (pos != end && *pos == '"') {
+                name.clear();
+
+                if ((pos = Scanner::decodeString(pos, end, name, error)) == nullptr) {
+                    return false;
+                }
+
+                pos = Scanner::skipWhitespace(pos, end);
+
+                if (pos == end || *pos != ':') {
+                    return false;
+                }
+
+                pos = Scanner::skipWhitespace(pos + 1, end);
+                const char *stop = Scanner::skipValue(pos, end);
+
+                if (stop == nullptr) {
+                    return false;
+                }
+
+                if (name == field) {
+                    key.clear();
+
+                    if (*pos == '"') {
+                        return Scanner::decodeString(pos, stop, key, error) != nullptr;
+                    }
+
+                    if (*pos == '[' || *pos == '{') {
+                        return false;
+                    }
+
+                    key.assign(pos, stop);
+                    return true;
+                }
+
+                pos = Scanner::skipWhitespace(stop, end);
+
+                if (pos == end || *pos != ',') {
+                    return false;
+                }
+
+                pos = Scanner::skipWhitespace(pos + 1, end);
+            }
+
+            return false;
+        }
+    };
+
+    bool OffsetIndex::find(std::string_view key, std::size_t &element) const {
+        auto found = keys.find(key);
+
+        if (found == keys.end()) {
+            return false;
+        }
+
+        element = (std::size_t)found->second;
+
+        return true;
+    }
+
+    bool OffsetIndex::build(std::string_view text, OffsetIndex &index, std::string_view field) {
+        const char *begin = text.data();
+        const char *end = begin + text.size();
+        const char *pos = Scanner::skipWhitespace(begin, end);
+
+        if (pos == end || *pos != '[') {
+            return false;
+        }
+
+        OffsetIndex built;
+        built.sourceSize = text.size();
+        built.field = field;
+
+        pos = Scanner::skipWhitespace(pos + 1, end);
+        bool empty = (pos != end && *pos == ']');
+
+        if (empty) {
+            ++pos;
+        }
+
+        std::string name;
+        std::string key;
+
+        while (!empty) {
+            const char *stop = Scanner::skipValue(pos, end);
+
+            if (stop == nullptr) {
+                return false;
+            }
+
+            if (!field.empty() && *pos == '{' && memberKey(pos, stop, field, name, key)) {
+                built.keys.try_emplace(key, built.offsets.size());
+            }
+
+            built.offsets.push_back((std::uint64_t)(pos - begin));
+            pos = Scanner::skipWhitespace(stop, end);
+
+            if (pos == end) {
+                return false;
+            }
+
+            char separator = *pos++;
+
+            if (separator == ']') {
+                break;
+            }
+
+            if (separator != ',') {
+                return false;
+            }
+
+            pos = Scanner::skipWhitespace(pos, end);
+        }
+
+        // only whitespace may follow the Array
+        if (Scanner::skipWhitespace(pos, end) != end) {
+            return false;
+        }
+
+        index = std::move(built);
+
+        return true;
+    }
+
+    bool OffsetIndex::buildFile(const fs::path &file, const fs::path &sidecar, std::string_view field) {
+        std::error_code error;
+        std::int64_t modified = modificationTime(file, error);
+
+        if (error) {
+            return false;
+        }
+
+        std::size_t length = 0;
+        const char *data = mapFile(file, length, MADV_SEQUENTIAL);
+
+        if (data == nullptr) {
+            return false;
+        }
+
+        OffsetIndex index;
+        bool built = build(std::string_view(data, length), index, field);
+        ::munmap((void *)data, length);
+
+        if (!built) {
+            return false;
+        }
+
+        index.sourceModified = modified;
+
+        return index.save(sidecar);
+    }
+
+    bool OffsetIndex::save(const fs::path &sidecar) const {
+        std::string output(MAGIC, sizeof(MAGIC));
+        output.reserve(sizeof(MAGIC) + (offsets.size() + 4) * sizeof(std::uint64_t));
+
+        putInteger(output, sourceSize);
+        putInteger(output, (std::uint64_t)sourceModified);
+        putInteger(output, offsets.size());
+
+        for (std::uint64_t offset : offsets) {
+            putInteger(output, offset);
+        }
+
+        putString(output, field);
+        putInteger(output, keys.size());
+
+        for (const auto &[key, element] : keys) {
+            putString(output, key);
+            putInteger(output, element);
+        }
+
+        // written beside the sidecar and renamed over it, so a reader
+        // never sees half of it
+        fs::path temporary = sidecar;
+        temporary += ".tmp";
+
+        {
+            std::ofstream file{ temporary, std::ios::binary | std::ios::trunc };
+            file.write(output.data(), (std::streamsize)output.size());
+
+            if (!file) {
+                return false;
+            }
+        }
+
+        std::error_code error;
+        fs::rename(temporary, sidecar, error);
+
+        return !error;
+    }
+
+    bool OffsetIndex::load(const fs::path &sidecar, OffsetIndex &index) {
+        std::ifstream file{ sidecar, std::ios::binary };
+
+        if (!file.is_open()) {
+            return false;
+        }
+
+        std::string input((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        if (input.size() < sizeof(MAGIC) || std::memcmp(input.data(), MAGIC, sizeof(MAGIC)) != 0) {
+            return false;
+        }
+
+        SidecarReader reader(std::string_view(input).substr(sizeof(MAGIC)));
+        OffsetIndex loaded;
+        std::uint64_t modified = 0;
+        std::uint64_t count = 0;
+
+        if (!reader.integer(loaded.sourceSize) || !reader.integer(modified) || !reader.integer(count) || count > input.size() / sizeof(std::uint64_t)) {
+            return false;
+        }
+
+        loaded.sourceModified = (std::int64_t)modified;
+        loaded.offsets.resize((std::size_t)count);
+
+        for (std::uint64_t &offset : loaded.offsets) {
+            if (!reader.integer(offset) || offset >= loaded.sourceSize) {
+                return false;
+            }
+        }
+
+        if (!reader.string(loaded.field) || !reader.integer(count)) {
+            return false;
+        }
+
+        std::string key;
+
+        for (std::uint64_t i = 0; i < count; ++i) {
+            std::uint64_t element = 0;
+
+            if (!reader.string(key) || !reader.integer(element) || element >= loaded.offsets.size()) {
+                return false;
+            }
+
+            loaded.keys.emplace(key, element);
+        }
+
+        if (!reader.finished()) {
+            return false;
+        }
+
+        index = std::move(loaded);
+
+        return true;
+    }
+
+    IndexedFile::IndexedFile(const ParseOptions &options)
+        : options(options), data(nullptr), length(0)
+    {
+    }
+
+    IndexedFile::~IndexedFile() {
+        close();
+    }
+
+    bool IndexedFile::open(const fs::path &file, const fs::path &sidecar) {
+        close();
+
+        std::error_code error;
+        std::int64_t modified = modificationTime(file, error);
+
+        if (error || !OffsetIndex::load(sidecar, index)) {
+            return false;
+        }
+
+        // lookups jump around, reading ahead would only waste the cache
+        data = mapFile(file, length, MADV_RANDOM);
+
+        if (data == nullptr || length != index.sourceSize || modified != index.sourceModified) {
+            close();
+            return false;
+        }
+
+        return true;
+    }
+
+    void IndexedFile::close() {
+        if (data != nullptr) {
+            ::munmap((void *)data, length);
+        }
+
+        data = nullptr;
+        length = 0;
+        index = OffsetIndex();
+    }
+
+    Json IndexedFile::parse(Parser &parser, std::size_t i) const {
+        Json result;
+
+        if (i >= index.size()) {
+            return result;
+        }
+
+        const char *begin = data + index.offset(i);
+        const char *stop = Scanner::skipValue(begin, data + length);
+
+        if (stop == nullptr || !parser.parse(begin, (std::size_t)(stop - begin), result)) {
+            return Json();
+        }
+
+        return result;
+    }
+
+    Json IndexedFile::element(std::size_t i) const {
+        Parser parser(options);
+        return parse(parser, i);
+    }
+
+    Json IndexedFile::find(std::string_view key) const {
+        std::size_t i = 0;
+
+        if (!index.find(key, i)) {
+            return Json();
+        }
+
+        return element(i);
+    }
+
+    std::vector<Json> IndexedFile::range(std::size_t first, std::size_t count) const {
+        std::vector<Json> elements;
+
+        if (first >= index.size()) {
+            return elements;
+        }
+
+        count = std::min(count, index.size() - first);
+        elements.reserve(count);
+
+        // one parser for all elements keeps its stacks warm
+        Parser parser(options);
+
+        for (std::size_t i = first; i < first + count; ++i) {
+            elements.push_back(parse(parser, i));
+        }
+
+        return elements;
+    }
+
+}; // namespace JSON
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "json.hpp"
+
+namespace JSON {
+
+    class Parser;
+
+    /**
+     * The byte offsets of the elements of a top-level Array, built in one
+     * pass over its text and kept in a sidecar file next to it.
+     *
+     * Elements are found by matching brackets and quotes only, so the
+     * pass is about as fast as reading the file, and a malformed element
+     * is only noticed when it is parsed. Optionally the index also maps
+     * the value of one member of Object elements to the element, string
+     * values by their content and other scalars by their text, the first
+     * element with a value wins.
+     * */
+    class OffsetIndex {
+        friend class IndexedFile;
+
+        public:
+            std::size_t size() const { return offsets.size(); }
+
+            // where element i begins in the text
+            std::uint64_t offset(std::size_t i) const { return offsets[i]; }
+
+            // the member the keys are taken from, empty if there are none
+            const std::string &keyField() const { return field; }
+
+            /**
+             * @param[out] element
+             *     The index of the element with that value of keyField().
+             *
+             * @return
+             *     false if no element has it
+             * */
+            bool find(std::string_view key, std::size_t &element) const;
+
+            /**
+             * This method indexes the text of a top-level Array
+             *
+             * @param[in] field
+             *     The member whose values become keys, empty for none.
+             *
+             * @param[out] index
+             *     The index, left empty when the text is rejected.
+             *
+             * @return
+             *     false if the text is not an Array
+             * */
+            static bool build(std::string_view text, OffsetIndex &index, std::string_view field = {});
+
+            /**
+             * This method indexes a file through mmap() and writes the
+             * index to a sidecar file, which records the size and the
+             * modification time of the file it was built for
+             *
+             * @return
+             *     false if the file can not be read, is not an Array, or
+             *     the sidecar can not be written
+             * */
+            static bool buildFile(const std::filesystem::path &file, const std::filesystem::path &sidecar, std::string_view field = {});
+
+            bool save(const std::filesystem::path &sidecar) const;
+
+            /**
+             * @return
+             *     false if the sidecar is missing or malformed
+             * */
+            static bool load(const std::filesystem::path &sidecar, OffsetIndex &index);
+
+        private:
+            std::vector<std::uint64_t> offsets;
+            std::uint64_t sourceSize = 0;
+            std::int64_t sourceModified = 0;
+
+            std::string field;
+            std::unordered_map<std::string, std::uint64_t, KeyHash, KeyEqual> keys;
+    };
+
+
+    /**
+     * A file holding a top-level Array, mapped into memory and read
+     * through its OffsetIndex, so that looking up an element parses
+     * only that element and touches only its pages.
+     * */
+    class IndexedFile {
+        public:
+            explicit IndexedFile(const ParseOptions &options = {});
+            ~IndexedFile();
+
+            IndexedFile(const IndexedFile &) = delete;
+            IndexedFile &operator=(const IndexedFile &) = delete;
+
+            /**
+             * This method maps a file and loads its sidecar index
+             *
+             * @return
+             *     false if either can not be read, or if the sidecar was
+             *     built for another size or modification time of the file
+             * */
+            bool open(const std::filesystem::path &file, const std::filesystem::path &sidecar);
+
+            void close();
+
+            std::size_t size() const { return index.size(); }
+            const OffsetIndex &getIndex() const { return index; }
+
+            /**
+             * These methods parse one element, by position or by its
+             * key, and are safe to call from several threads at once
+             *
+             * @return
+             *     The element, Invalid if there is none or it is malformed
+             * */
+            Json element(std::size_t i) const;
+            Json find(std::string_view key) const;
+
+            /**
+             * This method parses count elements from first on, as many
+             * as there are
+             *
+             * @return
+             *     The elements, malformed ones are Invalid
+             * */
+            std::vector<Json> range(std::size_t first, std::size_t count) const;
+
+        private:
+            Json parse(Parser &parser, std::size_t i) const;
+
+        private:
+            ParseOptions options;
+            OffsetIndex index;
+            const char *data;
+            std::size_t length;
+    };
+
+}; // namespace JSON
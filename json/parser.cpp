@@ -0,0 +1,375 @@
+#include <algorithm>
+#include <charconv>
+#include <limits>
+#include <new>
+
+#include "parser.hpp"
+#include "scanner.hpp"
+
+namespace JSON {
+
+    namespace {
+
+        // frames are preallocated up to this depth, deeper input grows the stack
+        constexpr std::size_t PREALLOCATED_DEPTH = 1024;
+
+        // the frame offsets are 32 and 31 bits wide
+        constexpr std::size_t MAX_PENDING_VALUES = std::numeric_limits<std::uint32_t>::max();
+        constexpr std::size_t MAX_PENDING_KEYS = MAX_PENDING_VALUES >> 1;
+
+        /**
+         * Whether a number is written back the same once it is packed,
+         * that is whether its text is already the one a packed number is
+         * written with: the decimal digits of a long long, or the shortest
+         * digits that read back as the same double, with ".0" when they
+         * have no fraction or exponent, like Json::fromPacked() gives
+         * */
+        bool packable(const Json &value) {
+            const Number &number = value.getNumber();
+            std::string_view text = number.text();
+
+            char digits[32];
+            char *end = nullptr;
+
+            if (number.getClass() == Number::Class::Int64) {
+                end = std::to_chars(digits, digits + sizeof(digits), number.toInt64()).ptr;
+            } else if (number.getClass() == Number::Class::Double) {
+                double floatingPoint = 0;
+
+                if (std::from_chars(text.data(), text.data() + text.size(), floatingPoint).ec != std::errc()) {
+                    return false;
+                }
+
+                end = std::to_chars(digits, digits + sizeof(digits) - 2, floatingPoint).ptr;
+
+                if (std::find_if(digits, end, [](char c) { return c == '.' || c == 'e'; }) == end) {
+                    *end++ = '.';
+                    *end++ = '0';
+                }
+            } else {
+                return false;
+            }
+
+            return text == std::string_view(digits, (std::size_t)(end - digits));
+        }
+    };
+
+    Parser::Parser(const ParseOptions &options)
+        : options(options), resource(nullptr), document(nullptr), begin(nullptr), error(nullptr)
+    {
+        frames.reserve(std::min(options.maxDepth, PREALLOCATED_DEPTH));
+    }
+
+    std::size_t Parser::errorOffset() const {
+        return (std::size_t)(error - begin);
+    }
+
+    bool Parser::fail(const char *pos) {
+        error = pos;
+
+        frames.clear();
+        values.clear();
+        keys.clear();
+
+        return false;
+    }
+
+    bool Parser::parse(const char *data, std::size_t size, Json &result) {
+        return parse(data, size, result, options.resource == nullptr ? Memory::defaultResource() : options.resource);
+    }
+
+    Json *Parser::parseInArena(const char *data, std::size_t size) {
+        // the interner holds copies of nodes of the previous document
+        interner.reset();
+        arena.reset();
+
+        // the previous document is dropped along with the arena, its
+        // nodes are never destroyed one by one
+        document = new (arena.allocate(sizeof(Json), alignof(Json))) Json();
+
+        if (!parse(data, size, *document, &arena)) {
+            return nullptr;
+        }
+
+        return document;
+    }
+
+    bool Parser::parse(const char *data, std::size_t size, Json &result, std::pmr::memory_resource *nodeResource) {
+        const char *end = data + size;
+        const char *pos = data;
+
+        begin = data;
+        error = nullptr;
+        resource = nodeResource;
+
+        if (options.deduplicate) {
+            interner = std::make_unique<Interner>(options.maxSharedSize);
+        }
+
+        // true while a value is due at pos, false once one has ended there
+        bool expectValue = true;
+
+        while (true) {
+            pos = Scanner::skipWhitespace(pos, end);
+
+            if (expectValue) {
+                if (pos == end) {
+                    return fail(pos);
+                }
+
+                if (*pos == '[' || *pos == '{') {
+                    bool object = (*pos == '{');
+
+                    if (frames.size() >= options.maxDepth || values.size() > MAX_PENDING_VALUES || keys.size() > MAX_PENDING_KEYS) {
+                        return fail(pos);
+                    }
+
+                    frames.push_back({ (std::uint32_t)values.size(), (std::uint32_t)keys.size(), object });
+                    pos = Scanner::skipWhitespace(pos + 1, end);
+
+                    if (pos != end && *pos == (object ? '}' : ']')) {
+                        close();
+                        ++pos;
+                        expectValue = false;
+                        continue;
+                    }
+
+                    if (object && (pos = parseKey(pos, end)) == nullptr) {
+                        return false;
+                    }
+
+                    continue;
+                }
+
+                values.emplace_back();
+
+                if ((pos = parseScalar(pos, end, values.back())) == nullptr) {
+                    return false;
+                }
+
+                expectValue = false;
+                continue;
+            }
+
+            if (frames.empty()) {
+                if (pos != end) {
+                    return fail(pos);
+                }
+
+                result = std::move(values.back());
+                values.clear();
+
+                return true;
+            }
+
+            if (pos == end) {
+                return fail(pos);
+            }
+
+            bool object = frames.back().object;
+
+            if (*pos == ',') {
+                pos = Scanner::skipWhitespace(pos + 1, end);
+
+                if (object && (pos = parseKey(pos, end)) == nullptr) {
+                    return false;
+                }
+
+                expectValue = true;
+            } else if (*pos == (object ? '}' : ']')) {
+                close();
+                ++pos;
+            } else {
+                return fail(pos);
+            }
+        }
+    }
+
+    const char *Parser::parseKey(const char *pos, const char *end) {
+        if (pos == end || *pos != '"') {
+            fail(pos);
+            return nullptr;
+        }
+
+        keys.emplace_back(resource);
+        const char *stop = Scanner::decodeString(pos, end, keys.back(), error);
+
+        if (stop == nullptr) {
+            fail(error);
+            return nullptr;
+        }
+
+        pos = Scanner::skipWhitespace(stop, end);
+
+        if (pos == end || *pos != ':') {
+            fail(pos);
+            return nullptr;
+        }
+
+        return pos + 1;
+    }
+
+    const char *Parser::parseScalar(const char *pos, const char *end, Json &value) {
+        const char *stop = nullptr;
+
+        switch (*pos) {
+            case '"': {
+                auto string = Json::allocate<Json::Text>(resource);
+                stop = Scanner::decodeString(pos, end, *string, error);
+
+                if (stop != nullptr) {
+                    value.type = Json::Type::String;
+                    value.value = std::move(string);
+                }
+            } break;
+
+            case 't': {
+                if ((stop = Scanner::validateLiteral(pos, end, "true", 4, error)) != nullptr) {
+                    value = true;
+                }
+            } break;
+
+            case 'f': {
+                if ((stop = Scanner::validateLiteral(pos, end, "false", 5, error)) != nullptr) {
+                    value = false;
+                }
+            } break;
+
+            case 'n': {
+                if ((stop = Scanner::validateLiteral(pos, end, "null", 4, error)) != nullptr) {
+                    value = nullptr;
+                }
+            } break;
+
+            default: {
+                return parseNumber(pos, end, value);
+            }
+        }
+
+        if (stop == nullptr) {
+            fail(error);
+            return nullptr;
+        }
+
+        finish(value);
+
+        return stop;
+    }
+
+    const char *Parser::parseNumber(const char *pos, const char *end, Json &value) {
+        const char *stop = Scanner::validateNumber(pos, end, error);
+
+        if (stop == nullptr) {
+            fail(error);
+            return nullptr;
+        }
+
+        // only the digits are kept, they are converted when read
+        Number number(std::string_view(pos, (std::size_t)(stop - pos)), resource);
+
+        if (number.isIntegral()) {
+            value.type = Json::Type::Integer;
+            value.value.emplace<Json::Type::Integer>(std::move(number));
+        } else {
+            value.type = Json::Type::FloatingPoint;
+            value.value.emplace<Json::Type::FloatingPoint>(std::move(number));
+        }
+
+        return stop;
+    }
+
+    void Parser::close() {
+        Frame frame = frames.back();
+        frames.pop_back();
+
+        auto first = values.begin() + frame.values;
+        Json container;
+
+        if (frame.object) {
+            auto members = Json::allocate<Json::Members>(resource);
+            auto key = keys.begin() + frame.keys;
+            members->reserve((std::size_t)(values.end() - first));
+
+            // the last of duplicate names wins, like in parseObject()
+            for (auto value = first; value != values.end(); ++value, ++key) {
+                members->insert_or_assign(std::move(*key), std::move(*value));
+            }
+
+            keys.resize(frame.keys);
+            container.type = Json::Type::Object;
+            container.value = std::move(members);
+        } else if (options.packNumbers && pack(first, container)) {
+            values.resize(frame.values);
+            finish(container);
+            values.push_back(std::move(container));
+
+            return;
+        } else {
+            auto elements = Json::allocate<Json::Elements>(resource, std::make_move_iterator(first), std::make_move_iterator(values.end()));
+
+            container.type = Json::Type::Array;
+            container.value = std::move(elements);
+        }
+
+        values.resize(frame.values);
+        finish(container);
+        values.push_back(std::move(container));
+    }
+
+    bool Parser::pack(std::vector<Json>::iterator first, Json &container) {
+        if (first == values.end()) {
+            return false;
+        }
+
+        Json::Type type = first->type;
+
+        if (type != Json::Type::Integer && type != Json::Type::FloatingPoint) {
+            return false;
+        }
+
+        for (auto value = first; value != values.end(); ++value) {
+            if (value->type != type || !packable(*value)) {
+                return false;
+            }
+        }
+
+        auto elements = Json::allocate<Json::Elements>(resource);
+        std::size_t count = (std::size_t)(values.end() - first);
+
+        if (type == Json::Type::Integer) {
+            Json::Elements::Integers integers(elements->get_allocator());
+            integers.reserve(count);
+
+            for (auto value = first; value != values.end(); ++value) {
+                integers.push_back(std::get<Json::Type::Integer>(value->value).toInt64());
+            }
+
+            elements->packed = std::move(integers);
+        } else {
+            Json::Elements::Doubles doubles(elements->get_allocator());
+            doubles.reserve(count);
+
+            for (auto value = first; value != values.end(); ++value) {
+                doubles.push_back(std::get<Json::Type::FloatingPoint>(value->value).toDouble());
+            }
+
+            elements->packed = std::move(doubles);
+        }
+
+        container.type = Json::Type::Array;
+        container.value = std::move(elements);
+
+        return true;
+    }
+
+    void Parser::finish(Json &value) {
+        if (interner) {
+            interner->intern(value);
+        }
+
+        if (options.computeHashes && (value.type == Json::Type::Array || value.type == Json::Type::Object)) {
+            value.hash();
+        }
+    }
+
+}; // namespace JSON
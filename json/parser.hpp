@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "arena.hpp"
+#include "interner.hpp"
+#include "json.hpp"
+
+namespace JSON {
+
+    /**
+     * Parser for RFC 8259 JSON text that never recurses.
+     *
+     * Open containers are kept on an explicit stack of small frames, and
+     * the finished children of every open container wait on one shared
+     * value stack until the container closes, at which point they are
+     * moved into a container of exactly the right size. Nesting costs a
+     * frame of 8 bytes per level, so deep input needs neither a deep
+     * call stack nor more memory than flat input, and it is limited by
+     * ParseOptions::maxDepth instead of by the size of the thread stack.
+     * Strings and containers are allocated from ParseOptions::resource,
+     * the stacks themselves are not and are kept between parses.
+     *
+     * A parser is meant to be kept, one per thread, and used for many
+     * documents. parseInArena() also keeps the nodes in an arena of the
+     * parser that is reset for every document, so once the stacks and
+     * the arena have grown to the size of the documents, parsing them
+     * allocates nothing on the heap.
+     * */
+    class Parser {
+        public:
+            explicit Parser(const ParseOptions &options = {});
+
+            /**
+             * This method parses a single value with nothing but whitespace
+             * around it
+             *
+             * @param[out] result
+             *     The parsed value, left untouched on failure.
+             *
+             * @return
+             *     Whether the input is well-formed
+             * */
+            bool parse(const char *data, std::size_t size, Json &result);
+
+            /**
+             * This method parses a single value into the arena of the
+             * parser, after freeing the previous document in constant
+             * time. Options that need the heap, like deduplicate, still
+             * allocate.
+             *
+             * @return
+             *     The document, nullptr if the input is malformed. It and
+             *     every copy of it are valid until the next call or until
+             *     the parser is destroyed, and must not be used after.
+             * */
+            Json *parseInArena(const char *data, std::size_t size);
+
+            // the memory held by the arena of parseInArena()
+            const Arena &getArena() const { return arena; }
+
+            // offset of the first byte that broke the grammar in the last parse
+            std::size_t errorOffset() const;
+
+        private:
+            struct Frame {
+                std::uint32_t values;       // start of the children on the value stack
+                std::uint32_t keys : 31;    // start of the member names on the key stack
+                std::uint32_t object : 1;
+            };
+
+            bool parse(const char *data, std::size_t size, Json &result, std::pmr::memory_resource *nodeResource);
+            const char *parseKey(const char *pos, const char *end);
+            const char *parseScalar(const char *pos, const char *end, Json &value);
+            const char *parseNumber(const char *pos, const char *end, Json &value);
+            void close();
+            bool pack(std::vector<Json>::iterator first, Json &container);
+            void finish(Json &value);
+            bool fail(const char *pos);
+
+        private:
+            ParseOptions options;
+            std::unique_ptr<Interner> interner;
+
+            // where the nodes of the current parse are allocated
+            std::pmr::memory_resource *resource;
+
+            Arena arena;
+            Json *document;
+
+            std::vector<Frame> frames;
+            std::vector<Json> values;
+            // names are allocated from the document resource up front so
+            // that they move into their object without a copy
+            std::vector<Json::Text> keys;
+
+            const char *begin;
+            const char *error;
+    };
+
+}; // namespace JSON
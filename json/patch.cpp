@@ -0,0 +1,552 @@
+#include <algorithm>
+
+#include "json.hpp"
+
+namespace JSON {
+
+    /**
+     * Applies JSON Patch operations to a document in place.
+     *
+     * The containers resolved for the previous operation are kept as a
+     * chain from the root, so operations sharing a path prefix only walk
+     * the part of the path that differs. Every change is recorded as the
+     * operation that reverts it.
+     * */
+    class Patcher {
+        public:
+            Patcher(Json &root, bool record)
+                : record(record)
+            {
+                chain.push_back(&root);
+            }
+
+            bool apply(const Json &operation);
+
+            // the operations that revert everything applied so far
+            std::vector<Json> undo;
+
+        private:
+            using Tokens = std::vector<std::string>;
+
+            bool add(const Tokens &path, const Json &value);
+            bool remove(const Tokens &path, Json *removed);
+            bool replace(const Tokens &path, const Json &value);
+            Json *resolve(const Tokens &path, std::size_t depth);
+            void invalidateBelow(std::size_t depth);
+            void recordUndo(const char *name, const Tokens &path, const Json *value);
+
+        public:
+            static const Json *member(const Json &object, const char *key);
+            static bool parsePointer(const Json *pointer, Tokens &tokens);
+            static std::string formatPointer(const Tokens &tokens, std::size_t depth);
+            static bool parseIndex(const std::string &token, std::size_t size, std::size_t &index);
+            static Json operation(const char *name, const Tokens &path, const Json *value);
+            static void merge(Json &target, const Json &patch, Tokens &path, std::vector<Json> *undo);
+            static void diff(const Json &from, const Json &to, Tokens &path, std::pmr::vector<Json> &operations, bool confirmEqual);
+
+        private:
+            bool record;
+            std::vector<Json *> chain;
+            Tokens chainTokens;
+    };
+
+    const Json *Patcher::member(const Json &object, const char *key) {
+        if (!object.isObject()) {
+            return nullptr;
+        }
+
+        const auto &members = *(std::get<Json::Type::Object>(object.value));
+        auto found = members.find(key);
+
+        return found == members.end() ? nullptr : &found->second;
+    }
+
+    bool Patcher::parsePointer(const Json *pointer, Tokens &tokens) {
+        if (pointer == nullptr || !pointer->isString()) {
+            return false;
+        }
+
+        std::string_view text = *(std::get<Json::Type::String>(pointer->value));
+
+        if (!text.empty() && text.front() != '/') {
+            return false;
+        }
+
+        for (std::size_t i = 0; i < text.size(); ++i) {
+            char c = text[i];
+
+            if (c == '/') {
+                tokens.emplace_back();
+            } else if (c == '~') {
+                // "~0" is '~' and "~1" is '/'
+                if (i + 1 == text.size() || (text[i + 1] != '0' && text[i + 1] != '1')) {
+                    return false;
+                }
+
+                tokens.back().push_back(text[++i] == '0' ? '~' : '/');
+            } else {
+                tokens.back().push_back(c);
+            }
+        }
+
+        return true;
+    }
+
+    std::string Patcher::formatPointer(const Tokens &tokens, std::size_t depth) {
+        std::string text;
+
+        for (std::size_t i = 0; i < depth; ++i) {
+            text.push_back('/');
+
+            for (const char &c : tokens[i]) {
+                if (c == '~') {
+                    text.append("~0");
+                } else if (c == '/') {
+                    text.append("~1");
+                } else {
+                    text.push_back(c);
+                }
+            }
+        }
+
+        return text;
+    }
+
+    bool Patcher::parseIndex(const std::string &token, std::size_t size, std::size_t &index) {
+        if (token.empty() || token.size() > 18 || (token.size() > 1 && token.front() == '0')) {
+            return false;
+        }
+
+        index = 0;
+
+        for (const char &c : token) {
+            if (c < '0' || c > '9') {
+                return false;
+            }
+
+            index = index * 10 + (std::size_t)(c - '0');
+        }
+
+        return index < size;
+    }
+
+    Json Patcher::operation(const char *name, const Tokens &path, const Json *value) {
+        Json operation(Json::Type::Object);
+        auto &members = *(std::get<Json::Type::Object>(operation.value));
+
+        members["op"] = name;
+        members["path"] = formatPointer(path, path.size());
+
+        if (value != nullptr) {
+            members["value"] = *value;
+        }
+
+        return operation;
+    }
+
+    Json *Patcher::resolve(const Tokens &path, std::size_t depth) {
+        // keep the part of the chain shared with the new path
+        std::size_t common = 0;
+
+        while (
+            common < depth &&
+            common < chainTokens.size() &&
+            chainTokens[common] == path[common]
+        ) {
+            ++common;
+        }
+
+        invalidateBelow(common);
+
+        for (std::size_t i = common; i < depth; ++i) {
+            Json *node = chain.back();
+            Json *next = nullptr;
+
+            if (node->isObject()) {
+                auto &members = *(std::get<Json::Type::Object>(node->value));
+
+                if (members.find(path[i]) == members.end()) {
+                    return nullptr;
+                }
+
+                next = &node->at(path[i]);
+            } else if (node->isArray()) {
+                std::size_t index = 0;
+
+                if (!parseIndex(path[i], node->size(), index)) {
+                    return nullptr;
+                }
+
+                next = &node->at((int)index);
+            } else {
+                return nullptr;
+            }
+
+            chain.push_back(next);
+            chainTokens.push_back(path[i]);
+        }
+
+        return chain.back();
+    }
+
+    void Patcher::invalidateBelow(std::size_t depth) {
+        // chain[depth] is the deepest node that stays valid
+        chain.resize(depth + 1);
+        chainTokens.resize(depth);
+    }
+
+    void Patcher::recordUndo(const char *name, const Tokens &path, const Json *value) {
+        if (record) {
+            undo.push_back(operation(name, path, value));
+        }
+    }
+
+    bool Patcher::add(const Tokens &path, const Json &value) {
+        if (path.empty()) {
+            Json old = *chain.front();
+            recordUndo("replace", path, &old);
+            *chain.front() = value;
+            invalidateBelow(0);
+
+            return true;
+        }
+
+        Json *parent = resolve(path, path.size() - 1);
+
+        if (parent == nullptr) {
+            return false;
+        }
+
+        const std::string &last = path.back();
+
+        if (parent->isObject()) {
+            const Json *existing = member(*parent, last.c_str());
+
+            if (existing != nullptr) {
+                Json old = *existing;
+                recordUndo("replace", path, &old);
+            } else {
+                recordUndo("remove", path, nullptr);
+            }
+
+            parent->insert(last, value);
+        } else if (parent->isArray()) {
+            std::size_t index = parent->size();
+
+            if (last != "-" && !parseIndex(last, parent->size() + 1, index)) {
+                return false;
+            }
+
+            Tokens concrete = path;
+            concrete.back() = std::to_string(index);
+            recordUndo("remove", concrete, nullptr);
+            parent->insert((int)index, value);
+        } else {
+            return false;
+        }
+
+        invalidateBelow(path.size() - 1);
+
+        return true;
+    }
+
+    bool Patcher::remove(const Tokens &path, Json *removed) {
+        Json *parent = path.empty() ? nullptr : resolve(path, path.size() - 1);
+
+        if (parent == nullptr) {
+            return false;
+        }
+
+        const std::string &last = path.back();
+
+        if (parent->isObject()) {
+            const Json *existing = member(*parent, last.c_str());
+
+            if (existing == nullptr) {
+                return false;
+            }
+
+            *removed = *existing;
+            parent->erase(last);
+        } else if (parent->isArray()) {
+            std::size_t index = 0;
+
+            if (!parseIndex(last, parent->size(), index)) {
+                return false;
+            }
+
+            *removed = parent->at((int)index);
+            parent->erase((int)index);
+        } else {
+            return false;
+        }
+
+        recordUndo("add", path, removed);
+        invalidateBelow(path.size() - 1);
+
+        return true;
+    }
+
+    bool Patcher::replace(const Tokens &path, const Json &value) {
+        Json *target = resolve(path, path.size());
+
+        if (target == nullptr) {
+            return false;
+        }
+
+        Json old = *target;
+        recordUndo("replace", path, &old);
+        *target = value;
+        invalidateBelow(path.size());
+
+        return true;
+    }
+
+    bool Patcher::apply(const Json &operation) {
+        const Json *name = member(operation, "op");
+        const Json *value = member(operation, "value");
+        Tokens path;
+
+        if (name == nullptr || !name->isString() || !parsePointer(member(operation, "path"), path)) {
+            return false;
+        }
+
+        std::string_view op = *(std::get<Json::Type::String>(name->value));
+
+        if (op == "add") {
+            return value != nullptr && add(path, *value);
+        }
+
+        if (op == "remove") {
+            Json removed;
+            return remove(path, &removed);
+        }
+
+        if (op == "replace") {
+            return value != nullptr && replace(path, *value);
+        }
+
+        if (op == "test") {
+            const Json *target = resolve(path, path.size());
+            return value != nullptr && target != nullptr && *target == *value;
+        }
+
+        Tokens from;
+
+        if (!parsePointer(member(operation, "from"), from)) {
+            return false;
+        }
+
+        if (op == "copy") {
+            const Json *source = resolve(from, from.size());
+
+            if (source == nullptr) {
+                return false;
+            }
+
+            // the copy shares its containers with the source, so nothing
+            // below the root may be reused without going through at() again
+            Json copy = *source;
+            invalidateBelow(0);
+
+            return add(path, copy);
+        }
+
+        if (op == "move") {
+            // a value cannot be moved into one of its own children
+            if (
+                from.size() < path.size() &&
+                std::equal(from.begin(), from.end(), path.begin())
+            ) {
+                return false;
+            }
+
+            Json moved;
+
+            return remove(from, &moved) && add(path, moved);
+        }
+
+        return false;
+    }
+
+    bool Json::applyPatch(const Json &patch, Json *inverse) {
+        if (!patch.isArray()) {
+            return false;
+        }
+
+        Patcher patcher(*this, true);
+
+        for (const auto &operation : std::get<Type::Array>(patch.value)->materialized()) {
+            if (patcher.apply(operation)) {
+                continue;
+            }
+
+            // roll back what was already applied
+            Patcher rollback(*this, false);
+
+            for (auto undo = patcher.undo.rbegin(); undo != patcher.undo.rend(); ++undo) {
+                rollback.apply(*undo);
+            }
+
+            return false;
+        }
+
+        if (inverse != nullptr) {
+            Json operations(Type::Array);
+            auto &elements = *(std::get<Type::Array>(operations.value));
+            elements.assign(
+                std::make_move_iterator(patcher.undo.rbegin()),
+                std::make_move_iterator(patcher.undo.rend()));
+            *inverse = std::move(operations);
+        }
+
+        return true;
+    }
+
+    void Patcher::merge(Json &target, const Json &patch, Tokens &path, std::vector<Json> *undo) {
+        if (!patch.isObject()) {
+            if (undo != nullptr) {
+                undo->push_back(operation("replace", path, &target));
+            }
+
+            target = patch;
+            return;
+        }
+
+        if (!target.isObject()) {
+            if (undo != nullptr) {
+                undo->push_back(operation("replace", path, &target));
+
+                // the members below are added to a fresh Object
+                undo = nullptr;
+            }
+
+            target = Json(Json::Type::Object);
+        }
+
+        for (const auto &pair : *(std::get<Json::Type::Object>(patch.value))) {
+            const std::string key{ pair.first };
+            const Json &value = pair.second;
+            const Json *existing = member(target, key.c_str());
+            path.push_back(key);
+
+            if (value.isNull()) {
+                if (existing != nullptr) {
+                    if (undo != nullptr) {
+                        undo->push_back(operation("add", path, existing));
+                    }
+
+                    target.erase(key);
+                }
+            } else if (existing != nullptr) {
+                merge(target.at(key), value, path, undo);
+            } else {
+                if (undo != nullptr) {
+                    undo->push_back(operation("remove", path, nullptr));
+                }
+
+                Json created;
+                target.insert(key, created);
+                Json &slot = target.at(key);
+                merge(slot, value, path, nullptr);
+            }
+
+            path.pop_back();
+        }
+    }
+
+    void Patcher::diff(const Json &from, const Json &to, Tokens &path, std::pmr::vector<Json> &operations, bool confirmEqual) {
+        if (from.type != to.type || (!from.isArray() && !from.isObject())) {
+            if (from.type != to.type || !from.equals(to)) {
+                operations.push_back(operation("replace", path, &to));
+            }
+
+            return;
+        }
+
+        // a shared node is an equal subtree, and so are equal hashes
+        // unless the caller wants collisions ruled out
+        bool shared = from.isArray() ?
+            std::get<Json::Type::Array>(from.value) == std::get<Json::Type::Array>(to.value) :
+            std::get<Json::Type::Object>(from.value) == std::get<Json::Type::Object>(to.value);
+
+        if (shared || (from.hash() == to.hash() && (!confirmEqual || from.equals(to)))) {
+            return;
+        }
+
+        if (from.isObject()) {
+            const auto &left = *(std::get<Json::Type::Object>(from.value));
+            const auto &right = *(std::get<Json::Type::Object>(to.value));
+
+            for (const auto &member : left) {
+                auto found = right.find(member.first);
+                path.emplace_back(member.first);
+
+                if (found == right.end()) {
+                    operations.push_back(operation("remove", path, nullptr));
+                } else {
+                    diff(member.second, found->second, path, operations, confirmEqual);
+                }
+
+                path.pop_back();
+            }
+
+            for (const auto &member : right) {
+                if (left.find(member.first) == left.end()) {
+                    path.emplace_back(member.first);
+                    operations.push_back(operation("add", path, &member.second));
+                    path.pop_back();
+                }
+            }
+
+            return;
+        }
+
+        const auto &left = std::get<Json::Type::Array>(from.value)->materialized();
+        const auto &right = std::get<Json::Type::Array>(to.value)->materialized();
+        std::size_t common = std::min(left.size(), right.size());
+
+        for (std::size_t i = 0; i < common; ++i) {
+            path.push_back(std::to_string(i));
+            diff(left[i], right[i], path, operations, confirmEqual);
+            path.pop_back();
+        }
+
+        for (std::size_t i = common; i < right.size(); ++i) {
+            path.push_back(std::to_string(i));
+            operations.push_back(operation("add", path, &right[i]));
+            path.pop_back();
+        }
+
+        // remove from the back so the remaining indices stay valid
+        for (std::size_t i = left.size(); i > common; --i) {
+            path.push_back(std::to_string(i - 1));
+            operations.push_back(operation("remove", path, nullptr));
+            path.pop_back();
+        }
+    }
+
+    Json Json::diff(const Json &from, const Json &to, bool confirmEqual) {
+        std::vector<std::string> path;
+        Json operations(Type::Array);
+
+        Patcher::diff(from, to, path, *(std::get<Type::Array>(operations.value)), confirmEqual);
+
+        return operations;
+    }
+
+    void Json::applyMergePatch(const Json &patch, Json *inverse) {
+        std::vector<std::string> path;
+        std::vector<Json> undo;
+
+        Patcher::merge(*this, patch, path, inverse != nullptr ? &undo : nullptr);
+
+        if (inverse != nullptr) {
+            Json operations(Type::Array);
+            auto &elements = *(std::get<Type::Array>(operations.value));
+            elements.assign(std::make_move_iterator(undo.rbegin()), std::make_move_iterator(undo.rend()));
+            *inverse = std::move(operations);
+        }
+    }
+
+}; // namespace JSON
@@ -0,0 +1,229 @@
+#include <algorithm>
+
+#include "json.hpp"
+#include "parser.hpp"
+#include "scanner.hpp"
+
+namespace JSON {
+
+    namespace {
+
+        // one step from a container to one of its children
+        struct Step {
+            int index;
+            std::string key;
+        };
+
+        // a value enclosing an edit, `depth` is the length of its path
+        struct Candidate {
+            std::size_t depth;
+            std::size_t start;
+            std::size_t end;
+        };
+
+        // a re-parsed value waiting to be spliced into the document
+        struct Splice {
+            std::vector<Step> path;
+            Json value;
+        };
+
+        /**
+         * Walks the text from the root down to the innermost value that
+         * contains the bytes [offset, offset + length), recording the
+         * path and the span of every value on the way
+         * */
+        bool locate(
+            const std::string &text,
+            std::size_t offset,
+            std::size_t length,
+            std::vector<Step> &path,
+            std::vector<Candidate> &candidates)
+        {
+            const char *begin = text.data();
+            const char *end = begin + text.size();
+            const char *pos = Scanner::skipWhitespace(begin, end);
+            const char *valueEnd = Scanner::skipValue(pos, end);
+
+            if (valueEnd == nullptr) {
+                return false;
+            }
+
+            candidates.push_back({ 0, (std::size_t)(pos - begin), (std::size_t)(valueEnd - begin) });
+
+            while (true) {
+                const char *container = begin + candidates.back().start;
+
+                if (*container != '[' && *container != '{') {
+                    return true;
+                }
+
+                bool object = (*container == '{');
+                bool found = false;
+                int index = 0;
+                pos = container + 1;
+
+                while (true) {
+                    pos = Scanner::skipWhitespace(pos, end);
+
+                    if (pos == end) {
+                        return false;
+                    }
+
+                    if (*pos == ']' || *pos == '}') {
+                        break;
+                    }
+
+                    Step step{ index, "" };
+
+                    if (object) {
+                        const char *error = nullptr;
+                        const char *keyEnd = (*pos == '"') ? Scanner::decodeString(pos, end, step.key, error) : nullptr;
+
+                        if (keyEnd == nullptr) {
+                            return false;
+                        }
+
+                        pos = Scanner::skipWhitespace(keyEnd, end);
+
+                        if (pos == end || *pos != ':') {
+                            return false;
+                        }
+
+                        pos = Scanner::skipWhitespace(pos + 1, end);
+                    }
+
+                    const char *childEnd = Scanner::skipValue(pos, end);
+
+                    if (childEnd == nullptr) {
+                        return false;
+                    }
+
+                    std::size_t childStart = (std::size_t)(pos - begin);
+                    std::size_t childStop = (std::size_t)(childEnd - begin);
+
+                    if (childStart > offset) {
+                        break;
+                    }
+
+                    if (offset + length <= childStop) {
+                        path.push_back(std::move(step));
+                        candidates.push_back({ path.size(), childStart, childStop });
+                        found = true;
+                        break;
+                    }
+
+                    pos = Scanner::skipWhitespace(childEnd, end);
+
+                    if (pos != end && *pos == ',') {
+                        ++pos;
+                    }
+
+                    ++index;
+                }
+
+                // the edit touches the container itself, not one of its children
+                if (!found) {
+                    return true;
+                }
+            }
+        }
+    };
+
+    bool Json::reparse(Json &document, std::string &text, const std::vector<TextEdit> &edits) {
+        std::vector<const TextEdit *> order;
+
+        for (const auto &edit : edits) {
+            order.push_back(&edit);
+        }
+
+        // later edits first, so the offsets of the others stay valid
+        std::sort(order.begin(), order.end(), [](const TextEdit *a, const TextEdit *b) {
+            return a->offset > b->offset;
+        });
+
+        std::size_t limit = text.size();
+
+        for (const auto *edit : order) {
+            if (edit->offset > limit || edit->length > limit - edit->offset) {
+                return false;
+            }
+
+            limit = edit->offset;
+        }
+
+        std::vector<TextEdit> undo;
+        std::vector<Splice> splices;
+        Parser parser;
+        bool failed = false;
+
+        for (const auto *edit : order) {
+            std::vector<Step> path;
+            std::vector<Candidate> candidates;
+
+            if (!locate(text, edit->offset, edit->length, path, candidates)) {
+                failed = true;
+                break;
+            }
+
+            undo.push_back({ edit->offset, edit->replacement.size(), text.substr(edit->offset, edit->length) });
+            text.replace(edit->offset, edit->length, edit->replacement);
+
+            const char *begin = text.data();
+            const char *end = begin + text.size();
+            bool spliced = false;
+
+            // try the innermost value first and widen until the new text
+            // of the value is well-formed on its own
+            for (auto candidate = candidates.rbegin(); candidate != candidates.rend(); ++candidate) {
+                std::size_t start = candidate->start;
+                std::size_t stop = candidate->end + edit->replacement.size() - edit->length;
+                Json value;
+
+                if (Scanner::skipValue(begin + start, end) != begin + stop) {
+                    continue;
+                }
+
+                // the root may keep the whitespace around it
+                if (candidate->depth == 0) {
+                    start = 0;
+                    stop = text.size();
+                }
+
+                if (parser.parse(begin + start, stop - start, value)) {
+                    path.resize(candidate->depth);
+                    splices.push_back({ std::move(path), std::move(value) });
+                    spliced = true;
+                    break;
+                }
+            }
+
+            if (!spliced) {
+                failed = true;
+                break;
+            }
+        }
+
+        if (failed) {
+            for (auto edit = undo.rbegin(); edit != undo.rend(); ++edit) {
+                text.replace(edit->offset, edit->length, edit->replacement);
+            }
+
+            return false;
+        }
+
+        // the splices are applied in the order they were parsed in, a splice
+        // of an enclosing value simply overwrites the earlier ones inside it
+        for (auto &splice : splices) {
+            Json *slot = &document;
+
+            for (const auto &step : splice.path) {
+                slot = slot->isObject() ? &slot->at(step.key) : &slot->at(step.index);
+            }
+
+            *slot = std::move(splice.value);
+        }
+
+        return true;
+    }
+
+}; // namespace JSON
@@ -0,0 +1,243 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+
+namespace JSON {
+
+    /**
+     * Lightweight structural scanning over raw JSON text.
+     *
+     * These functions find where values begin and end and check them
+     * against the grammar, they never allocate and never build Json
+     * values. Every function returns nullptr when the text is malformed
+     * or ends too early.
+     * */
+    namespace Scanner {
+
+        inline bool isWhitespace(char c) {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+        }
+
+        inline const char *skipWhitespace(const char *pos, const char *end) {
+            while (pos != end && isWhitespace(*pos)) {
+                ++pos;
+            }
+
+            return pos;
+        }
+
+        /**
+         * This function skips a string starting at its opening quote
+         *
+         * @return
+         *     A pointer just past the closing quote
+         * */
+        const char *skipString(const char *pos, const char *end);
+
+        /**
+         * This function skips a number, true, false or null
+         *
+         * @return
+         *     A pointer just past the last character of the value
+         * */
+        inline const char *skipScalar(const char *pos, const char *end) {
+            const char *start = pos;
+
+            while (pos != end) {
+                char c = *pos;
+
+                if (
+                    (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') ||
+                    c == '-' || c == '+' || c == '.' || c == 'E'
+                ) {
+                    ++pos;
+                } else {
+                    break;
+                }
+            }
+
+            return pos == start ? nullptr : pos;
+        }
+
+        inline bool isDigit(char c) {
+            return c >= '0' && c <= '9';
+        }
+
+        inline int hexValue(char c) {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        }
+
+        /**
+         * This function reads the four hex digits of a unicode escape
+         *
+         * @return
+         *     The code unit, or -1 if a digit is not hexadecimal
+         * */
+        inline long readHex4(const char *pos) {
+            long unit = 0;
+
+            for (int i = 0; i < 4; ++i) {
+                int digit = hexValue(pos[i]);
+
+                if (digit < 0) {
+                    return -1;
+                }
+
+                unit = (unit << 4) | digit;
+            }
+
+            return unit;
+        }
+
+        /**
+         * This function checks a string starting at its opening quote
+         * against RFC 8259: no unescaped control characters, only the
+         * defined escapes, paired surrogates and valid UTF-8
+         *
+         * @param[out] error
+         *     Set to the offending byte when the string is malformed.
+         *
+         * @return
+         *     A pointer just past the closing quote, or nullptr
+         * */
+        const char *validateString(const char *pos, const char *end, const char *&error);
+
+        /**
+         * This function checks a string like validateString() and
+         * appends its unescaped content to output
+         * */
+        const char *decodeString(const char *pos, const char *end, std::string &output, const char *&error);
+
+        // the same into a string that allocates from a memory resource
+        const char *decodeString(const char *pos, const char *end, std::pmr::string &output, const char *&error);
+
+        /**
+         * This function checks a number against the RFC 8259 grammar
+         * -? (0 | [1-9][0-9]*) (.[0-9]+)? ([eE][+-]?[0-9]+)?
+         *
+         * @param[out] error
+         *     Set to the offending byte when the number is malformed.
+         *
+         * @return
+         *     A pointer just past the number, or nullptr
+         * */
+        inline const char *validateNumber(const char *pos, const char *end, const char *&error) {
+            if (pos != end && *pos == '-') {
+                ++pos;
+            }
+
+            if (pos == end || !isDigit(*pos)) {
+                error = pos;
+                return nullptr;
+            }
+
+            if (*pos == '0') {
+                ++pos;
+            } else {
+                while (pos != end && isDigit(*pos)) {
+                    ++pos;
+                }
+            }
+
+            if (pos != end && *pos == '.') {
+                if (++pos == end || !isDigit(*pos)) {
+                    error = pos;
+                    return nullptr;
+                }
+
+                while (pos != end && isDigit(*pos)) {
+                    ++pos;
+                }
+            }
+
+            if (pos != end && (*pos == 'e' || *pos == 'E')) {
+                if (++pos != end && (*pos == '+' || *pos == '-')) {
+                    ++pos;
+                }
+
+                if (pos == end || !isDigit(*pos)) {
+                    error = pos;
+                    return nullptr;
+                }
+
+                while (pos != end && isDigit(*pos)) {
+                    ++pos;
+                }
+            }
+
+            return pos;
+        }
+
+        /**
+         * This function checks that the bytes at pos spell the literal
+         * true, false or null
+         * */
+        inline const char *validateLiteral(const char *pos, const char *end, const char *literal, std::size_t length, const char *&error) {
+            for (std::size_t i = 0; i < length; ++i, ++pos) {
+                if (pos == end || *pos != literal[i]) {
+                    error = pos;
+                    return nullptr;
+                }
+            }
+
+            return pos;
+        }
+
+        /**
+         * This function skips a whole value of any type, matching the
+         * brackets and braces of nested containers
+         *
+         * @return
+         *     A pointer just past the last character of the value
+         * */
+        inline const char *skipValue(const char *pos, const char *end) {
+            if (pos == end) {
+                return nullptr;
+            }
+
+            if (*pos == '"') {
+                return skipString(pos, end);
+            }
+
+            if (*pos != '[' && *pos != '{') {
+                return skipScalar(pos, end);
+            }
+
+            std::size_t depth = 0;
+
+            while (pos != end) {
+                switch (*pos) {
+                    case '"': {
+                        pos = skipString(pos, end);
+
+                        if (pos == nullptr) {
+                            return nullptr;
+                        }
+                    } continue;
+
+                    case '[':
+                    case '{': {
+                        ++depth;
+                    } break;
+
+                    case ']':
+                    case '}': {
+                        if (--depth == 0) {
+                            return pos + 1;
+                        }
+                    } break;
+                }
+
+                ++pos;
+            }
+
+            return nullptr;
+        }
+    };
+};
@@ -0,0 +1,457 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <deque>
+#include <exception>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if __has_include(<sys/uio.h>)
+#include <climits>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include "serialize.hpp"
+
+namespace JSON {
+
+    namespace {
+
+        // containers deeper than this are written whole by one thread
+        constexpr std::size_t MAX_SPLIT_DEPTH = 64;
+
+        // the most buffers handed on at once
+        constexpr std::size_t MAX_BATCH = 64;
+
+        // appends what is written to a string, so a run is written where it stays
+        class StringBuffer : public std::streambuf {
+            public:
+                explicit StringBuffer(std::string &text) : text(text) {}
+
+            protected:
+                int_type overflow(int_type c) override {
+                    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+                        text.push_back(traits_type::to_char_type(c));
+                    }
+
+                    return traits_type::not_eof(c);
+                }
+
+                std::streamsize xsputn(const char *data, std::streamsize size) override {
+                    text.append(data, (std::size_t)size);
+                    return size;
+                }
+
+            private:
+                std::string &text;
+        };
+    };
+
+    /**
+     * Splits a document into pieces of text in the order operator<<
+     * writes them: literal brackets, separators and names, and runs of
+     * elements or members that the threads write
+     * */
+    class Serializer {
+        public:
+            Serializer(const std::ostream *format, const SerializeOptions &options);
+
+            /**
+             * Plans the pieces of a document
+             *
+             * @return
+             *     false if it is not worth more than one thread
+             * */
+            bool plan(const Json &json);
+
+            /**
+             * Writes the runs on the threads and hands the pieces to
+             * consume() in order, a batch of those done at a time
+             *
+             * @return
+             *     false as soon as consume() does
+             * */
+            template<typename Consume>
+            bool run(Consume consume);
+
+        private:
+            using Member = Json::Members::value_type;
+
+            struct Piece {
+                std::string text;
+
+                // a run of elements or of members, neither for literal text
+                const Json::Elements *elements = nullptr;
+                const std::vector<const Member *> *members = nullptr;
+                std::size_t begin = 0;
+                std::size_t end = 0;
+
+                std::atomic<bool> ready{ false };
+                std::exception_ptr error;
+            };
+
+            void split(const Json &json, std::size_t depth, bool narrow);
+            bool splits(const Json &child, std::size_t depth, bool narrow) const;
+            void literal(std::string_view text);
+            void addRun(const Json::Elements *elements, const std::vector<const Member *> *members, std::size_t begin, std::size_t end);
+            void fill(Piece &piece) const;
+
+            // the number of elements or members of a container, 0 otherwise
+            static std::size_t count(const Json &json);
+
+        private:
+            const std::ostream *format;
+            std::size_t threads;
+            std::size_t chunkSize;
+
+            std::deque<Piece> pieces;
+            std::vector<Piece *> runs;
+
+            // the members of split Objects in the order of their maps
+            std::deque<std::vector<const Member *>> orders;
+    };
+
+    Serializer::Serializer(const std::ostream *format, const SerializeOptions &options)
+        : format(format),
+          threads(options.threads != 0 ? options.threads : std::max(std::thread::hardware_concurrency(), 1u)),
+          chunkSize(std::max<std::size_t>(options.chunkSize, 1))
+    {
+    }
+
+    std::size_t Serializer::count(const Json &json) {
+        switch (json.type) {
+            case Json::Type::Array: return std::get<Json::Type::Array>(json.value)->count();
+            case Json::Type::Object: return std::get<Json::Type::Object>(json.value)->size();
+            default: return 0;
+        }
+    }
+
+    bool Serializer::plan(const Json &json) {
+        if (threads <= 1 || count(json) == 0) {
+            return false;
+        }
+
+        split(json, 0, true);
+
+        return runs.size() > 1;
+    }
+
+    bool Serializer::splits(const Json &child, std::size_t depth, bool narrow) const {
+        std::size_t size = count(child);
+
+        // a parent with fewer children than threads has all of its
+        // containers split, to find the large ones below them
+        return size != 0 && depth < MAX_SPLIT_DEPTH && (size >= chunkSize || narrow);
+    }
+
+    void Serializer::split(const Json &json, std::size_t depth, bool narrow) {
+        // the children of a narrow container are split as well
+        bool narrowChildren = narrow && count(json) < threads;
+
+        if (json.type == Json::Type::Array) {
+            const auto &elements = *std::get<Json::Type::Array>(json.value);
+            std::size_t size = elements.count();
+
+            literal("[ ");
+
+            // packed numbers are never split further
+            if (elements.isPacked()) {
+                for (std::size_t begin = 0; begin < size; begin += chunkSize) {
+                    addRun(&elements, nullptr, begin, std::min(begin + chunkSize, size));
+                }
+
+                literal("]");
+                return;
+            }
+
+            std::size_t begin = 0;
+            std::size_t weight = 0;
+
+            for (std::size_t i = 0; i < size; ++i) {
+                const Json &child = elements[i];
+
+                if (splits(child, depth + 1, narrowChildren)) {
+                    addRun(&elements, nullptr, begin, i);
+                    split(child, depth + 1, narrowChildren);
+                    literal(", ");
+
+                    begin = i + 1;
+                    weight = 0;
+                    continue;
+                }
+
+                weight += 1 + count(child);
+
+                if (weight >= chunkSize) {
+                    addRun(&elements, nullptr, begin, i + 1);
+                    begin = i + 1;
+                    weight = 0;
+                }
+            }
+
+            addRun(&elements, nullptr, begin, size);
+            literal("]");
+
+            return;
+        }
+
+        const auto &members = *std::get<Json::Type::Object>(json.value);
+        auto &order = orders.emplace_back();
+
+        order.reserve(members.size());
+
+        for (const auto &member : members) {
+            order.push_back(&member);
+        }
+
+        literal("\n{\n");
+
+        std::size_t begin = 0;
+        std::size_t weight = 0;
+
+        for (std::size_t i = 0; i < order.size(); ++i) {
+            const Json &child = order[i]->second;
+
+            if (splits(child, depth + 1, narrowChildren)) {
+                addRun(nullptr, &order, begin, i);
+
+                literal("\t");
+                literal(order[i]->first);
+                literal(": ");
+                split(child, depth + 1, narrowChildren);
+                literal(",\n");
+
+                begin = i + 1;
+                weight = 0;
+                continue;
+            }
+
+            weight += 1 + count(child);
+
+            if (weight >= chunkSize) {
+                addRun(nullptr, &order, begin, i + 1);
+                begin = i + 1;
+                weight = 0;
+            }
+        }
+
+        addRun(nullptr, &order, begin, order.size());
+        literal("}\n");
+    }
+
+    void Serializer::literal(std::string_view text) {
+        // consecutive literals share a piece
+        if (pieces.empty() || pieces.back().elements != nullptr || pieces.back().members != nullptr) {
+            pieces.emplace_back().ready.store(true, std::memory_order_relaxed);
+        }
+
+        pieces.back().text.append(text);
+    }
+
+    void Serializer::addRun(const Json::Elements *elements, const std::vector<const Member *> *members, std::size_t begin, std::size_t end) {
+        if (begin == end) {
+            return;
+        }
+
+        Piece &piece = pieces.emplace_back();
+
+        piece.elements = elements;
+        piece.members = members;
+        piece.begin = begin;
+        piece.end = end;
+
+        runs.push_back(&piece);
+    }
+
+    void Serializer::fill(Piece &piece) const {
+        StringBuffer buffer(piece.text);
+        std::ostream output(&buffer);
+
+        if (format != nullptr) {
+            output.copyfmt(*format);
+        }
+
+        // the same text as operator<< writes for these elements or members
+        if (piece.elements != nullptr) {
+            for (std::size_t i = piece.begin; i < piece.end; ++i) {
+                if (piece.elements->isPacked()) {
+                    output << piece.elements->element(i) << ", ";
+                } else {
+                    output << (*piece.elements)[i] << ", ";
+                }
+            }
+        } else {
+            for (std::size_t i = piece.begin; i < piece.end; ++i) {
+                const Member &member = *(*piece.members)[i];
+                output << '\t' << member.first << ": " << member.second << ",\n";
+            }
+        }
+    }
+
+    template<typename Consume>
+    bool Serializer::run(Consume consume) {
+        std::atomic<std::size_t> next{ 0 };
+        std::atomic<bool> stop{ false };
+        std::vector<std::thread> workers;
+
+        auto work = [&]() {
+            while (!stop.load(std::memory_order_relaxed)) {
+                std::size_t index = next.fetch_add(1);
+
+                if (index >= runs.size()) {
+                    break;
+                }
+
+                Piece &piece = *runs[index];
+
+                try {
+                    fill(piece);
+                } catch (...) {
+                    piece.error = std::current_exception();
+                }
+
+                piece.ready.store(true, std::memory_order_release);
+                piece.ready.notify_one();
+            }
+        };
+
+        // joins the workers however the loop below is left
+        struct Joiner {
+            std::vector<std::thread> &workers;
+            std::atomic<bool> &stop;
+
+            ~Joiner() {
+                stop.store(true);
+
+                for (auto &worker : workers) {
+                    worker.join();
+                }
+            }
+        } joiner{ workers, stop };
+
+        for (std::size_t i = 0; i < std::min(threads, runs.size()); ++i) {
+            workers.emplace_back(work);
+        }
+
+        std::vector<std::string *> batch;
+        std::exception_ptr error;
+
+        for (auto piece = pieces.begin(); piece != pieces.end() && !error; ) {
+            piece->ready.wait(false, std::memory_order_acquire);
+            batch.clear();
+
+            // the pieces after it that are done already go along
+            while (piece != pieces.end() && batch.size() < MAX_BATCH && piece->ready.load(std::memory_order_acquire)) {
+                if (piece->error) {
+                    error = piece->error;
+                    break;
+                }
+
+                batch.push_back(&piece->text);
+                ++piece;
+            }
+
+            if (!batch.empty() && !consume(batch)) {
+                return false;
+            }
+
+            // written text is freed right away
+            for (auto *text : batch) {
+                std::string().swap(*text);
+            }
+        }
+
+        if (error) {
+            std::rethrow_exception(error);
+        }
+
+        return true;
+    }
+
+    void serialize(std::ostream &output, const Json &json, const SerializeOptions &options) {
+        Serializer serializer(&output, options);
+
+        // a width would only pad the first thing written
+        if (output.width() != 0 || !serializer.plan(json)) {
+            output << json;
+            return;
+        }
+
+        serializer.run([&output](const std::vector<std::string *> &batch) {
+            for (const auto *text : batch) {
+                output.write(text->data(), (std::streamsize)text->size());
+            }
+
+            return true;
+        });
+    }
+
+#if __has_include(<sys/uio.h>)
+    namespace {
+
+        // writes every byte of the buffers, resuming after partial writes
+        bool writeAll(int fd, std::vector<iovec> &buffers) {
+            std::size_t first = 0;
+
+            while (first < buffers.size()) {
+                std::size_t count = std::min<std::size_t>(buffers.size() - first, IOV_MAX);
+                ssize_t written = ::writev(fd, buffers.data() + first, (int)count);
+
+                if (written < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+
+                    return false;
+                }
+
+                std::size_t left = (std::size_t)written;
+
+                while (first < buffers.size() && left >= buffers[first].iov_len) {
+                    left -= buffers[first].iov_len;
+                    ++first;
+                }
+
+                if (left != 0) {
+                    buffers[first].iov_base = (char *)buffers[first].iov_base + left;
+                    buffers[first].iov_len -= left;
+                }
+            }
+
+            return true;
+        }
+    };
+
+    bool serialize(int fd, const Json &json, const SerializeOptions &options) {
+        Serializer serializer(nullptr, options);
+        std::vector<iovec> buffers;
+
+        if (!serializer.plan(json)) {
+            std::string text;
+            StringBuffer buffer(text);
+            std::ostream output(&buffer);
+
+            output << json;
+            buffers.push_back({ text.data(), text.size() });
+
+            return writeAll(fd, buffers);
+        }
+
+        return serializer.run([fd, &buffers](const std::vector<std::string *> &batch) {
+            buffers.clear();
+
+            for (auto *text : batch) {
+                if (!text->empty()) {
+                    buffers.push_back({ text->data(), text->size() });
+                }
+            }
+
+            return writeAll(fd, buffers);
+        });
+    }
+#endif
+
+}; // namespace JSON
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+
+#include "json.hpp"
+
+namespace JSON {
+
+    struct SerializeOptions {
+        // 0 for one per hardware thread
+        std::size_t threads = 0;
+
+        // about how many values one thread writes at a time, a value
+        // counts once plus once for each of its elements or members
+        std::size_t chunkSize = 4096;
+    };
+
+    /**
+     * This function writes the same bytes as output << json, on several
+     * threads when the document is large.
+     *
+     * Large Arrays and Objects, and the containers on the way to them
+     * from a root with few children, are split into runs of elements
+     * or members. Each run is written into a buffer of its own by one of
+     * the threads and the buffers are written out in order as they are
+     * done. The format flags, precision and locale of output apply to
+     * every buffer.
+     * */
+    void serialize(std::ostream &output, const Json &json, const SerializeOptions &options = {});
+
+#if __has_include(<sys/uio.h>)
+    /**
+     * This function writes the bytes of output << json to a file
+     * descriptor, handing the buffers of many runs to one writev() call
+     * instead of copying them into a stream
+     *
+     * @return
+     *     false if a write fails, errno tells why
+     * */
+    bool serialize(int fd, const Json &json, const SerializeOptions &options = {});
+#endif
+
+}; // namespace JSON
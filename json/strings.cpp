@@ -0,0 +1,299 @@
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "scanner.hpp"
+
+namespace JSON {
+
+    namespace Scanner {
+
+        namespace {
+
+            // Hoehrmann's UTF-8 automaton: the first 256 entries map bytes
+            // to classes, the rest map (state + class) to the next state
+            constexpr unsigned char UTF8_ACCEPT = 0;
+            constexpr unsigned char UTF8_REJECT = 12;
+
+            constexpr unsigned char UTF8_TABLE[] = {
+                0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+                0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+                0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+                0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+                1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, 9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,
+                7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7, 7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,
+                8,8,2,2,2,2,2,2,2,2,2,2,2,2,2,2, 2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,
+                10,3,3,3,3,3,3,3,3,3,3,3,3,4,3,3, 11,6,6,6,5,8,8,8,8,8,8,8,8,8,8,8,
+
+                0,12,24,36,60,96,84,12,12,12,48,72, 12,12,12,12,12,12,12,12,12,12,12,12,
+                12, 0,12,12,12,12,12, 0,12, 0,12,12, 12,24,12,12,12,12,12,24,12,24,12,12,
+                12,12,12,12,12,12,12,24,12,12,12,12, 12,24,12,12,12,12,12,12,12,24,12,12,
+                12,12,12,12,12,12,12,36,12,36,12,12, 12,36,12,12,12,12,12,36,12,36,12,12,
+                12,36,12,12,12,12,12,12,12,12,12,12
+            };
+
+            /**
+             * Returns the first byte that is a quote, a backslash or, if
+             * Validate is set, a control character or a non-ASCII byte
+             * */
+            template<bool Validate>
+            const char *findSpecial(const char *pos, const char *end) {
+#if defined(__SSE2__)
+                const __m128i quote = _mm_set1_epi8('"');
+                const __m128i backslash = _mm_set1_epi8('\\');
+                const __m128i control = _mm_set1_epi8(0x1F);
+
+                while (end - pos >= 16) {
+                    __m128i bytes = _mm_loadu_si128((const __m128i *)pos);
+                    __m128i special = _mm_or_si128(
+                        _mm_cmpeq_epi8(bytes, quote),
+                        _mm_cmpeq_epi8(bytes, backslash));
+                    int mask = 0;
+
+                    if (Validate) {
+                        // min(byte, 0x1F) == byte only for control characters,
+                        // and the sign bit is set for non-ASCII bytes
+                        special = _mm_or_si128(special, _mm_cmpeq_epi8(_mm_min_epu8(bytes, control), bytes));
+                        mask = _mm_movemask_epi8(bytes);
+                    }
+
+                    mask |= _mm_movemask_epi8(special);
+
+                    if (mask != 0) {
+                        return pos + __builtin_ctz((unsigned)mask);
+                    }
+
+                    pos += 16;
+                }
+#endif
+                for (; pos != end; ++pos) {
+                    unsigned char c = (unsigned char)*pos;
+
+                    if (c == '"' || c == '\\' || (Validate && (c < 0x20 || c >= 0x80))) {
+                        break;
+                    }
+                }
+
+                return pos;
+            }
+
+            /**
+             * Validates a run of non-ASCII code points
+             *
+             * @return
+             *     A pointer to the first ASCII byte after the run
+             * */
+            const char *validateUtf8Run(const char *pos, const char *end, const char *&error) {
+                unsigned state = UTF8_ACCEPT;
+                const char *sequence = pos;
+
+                for (; pos != end; ++pos) {
+                    unsigned char c = (unsigned char)*pos;
+
+                    if (state == UTF8_ACCEPT) {
+                        if (c < 0x80) {
+                            return pos;
+                        }
+
+                        sequence = pos;
+                    }
+
+                    state = UTF8_TABLE[256 + state + UTF8_TABLE[c]];
+
+                    if (state == UTF8_REJECT) {
+                        error = sequence;
+                        return nullptr;
+                    }
+                }
+
+                if (state != UTF8_ACCEPT) {
+                    error = sequence;
+                    return nullptr;
+                }
+
+                return pos;
+            }
+
+            template<typename String>
+            void appendUtf8(String &output, unsigned long codePoint) {
+                if (codePoint < 0x80) {
+                    output.push_back((char)codePoint);
+                } else if (codePoint < 0x800) {
+                    char bytes[2] = {
+                        (char)(0xC0 | (codePoint >> 6)),
+                        (char)(0x80 | (codePoint & 0x3F))
+                    };
+                    output.append(bytes, 2);
+                } else if (codePoint < 0x10000) {
+                    char bytes[3] = {
+                        (char)(0xE0 | (codePoint >> 12)),
+                        (char)(0x80 | ((codePoint >> 6) & 0x3F)),
+                        (char)(0x80 | (codePoint & 0x3F))
+                    };
+                    output.append(bytes, 3);
+                } else {
+                    char bytes[4] = {
+                        (char)(0xF0 | (codePoint >> 18)),
+                        (char)(0x80 | ((codePoint >> 12) & 0x3F)),
+                        (char)(0x80 | ((codePoint >> 6) & 0x3F)),
+                        (char)(0x80 | (codePoint & 0x3F))
+                    };
+                    output.append(bytes, 4);
+                }
+            }
+
+            /**
+             * Checks the escape sequence at pos and decodes it into output
+             * if output is not nullptr
+             *
+             * @return
+             *     A pointer just past the escape sequence, or nullptr
+             * */
+            template<typename String>
+            const char *decodeEscape(const char *pos, const char *end, String *output) {
+                if (end - pos < 2) {
+                    return nullptr;
+                }
+
+                char decoded = 0;
+
+                switch (pos[1]) {
+                    case '"': decoded = '"'; break;
+                    case '\\': decoded = '\\'; break;
+                    case '/': decoded = '/'; break;
+                    case 'b': decoded = '\b'; break;
+                    case 'f': decoded = '\f'; break;
+                    case 'n': decoded = '\n'; break;
+                    case 'r': decoded = '\r'; break;
+                    case 't': decoded = '\t'; break;
+
+                    case 'u': {
+                        long unit = (end - pos >= 6) ? readHex4(pos + 2) : -1;
+
+                        if (unit < 0 || (unit >= 0xDC00 && unit <= 0xDFFF)) {
+                            return nullptr;
+                        }
+
+                        unsigned long codePoint = (unsigned long)unit;
+                        std::size_t length = 6;
+
+                        // a high surrogate must be followed by a low one
+                        if (unit >= 0xD800 && unit <= 0xDBFF) {
+                            long low = (end - pos >= 12 && pos[6] == '\\' && pos[7] == 'u') ? readHex4(pos + 8) : -1;
+
+                            if (low < 0xDC00 || low > 0xDFFF) {
+                                return nullptr;
+                            }
+
+                            codePoint = 0x10000 + (((unsigned long)unit - 0xD800) << 10) + ((unsigned long)low - 0xDC00);
+                            length = 12;
+                        }
+
+                        if (output != nullptr) {
+                            appendUtf8(*output, codePoint);
+                        }
+
+                        return pos + length;
+                    }
+
+                    default: return nullptr;
+                }
+
+                if (output != nullptr) {
+                    output->push_back(decoded);
+                }
+
+                return pos + 2;
+            }
+
+            /**
+             * The string kernel: unescaped spans are found with wide
+             * compares and appended with a single copy, escapes are only
+             * decoded where they occur
+             * */
+            template<typename String>
+            const char *scanString(const char *pos, const char *end, String *output, const char *&error) {
+                const char *span = ++pos;
+
+                while (true) {
+                    pos = findSpecial<true>(pos, end);
+
+                    if (pos == end) {
+                        error = end;
+                        return nullptr;
+                    }
+
+                    unsigned char c = (unsigned char)*pos;
+
+                    // valid UTF-8 is copied along with the ASCII around it
+                    if (c >= 0x80) {
+                        pos = validateUtf8Run(pos, end, error);
+
+                        if (pos == nullptr) {
+                            return nullptr;
+                        }
+
+                        continue;
+                    }
+
+                    if (output != nullptr) {
+                        output->append(span, (std::size_t)(pos - span));
+                    }
+
+                    if (c == '"') {
+                        return pos + 1;
+                    }
+
+                    if (c < 0x20) {
+                        error = pos;
+                        return nullptr;
+                    }
+
+                    const char *next = decodeEscape(pos, end, output);
+
+                    if (next == nullptr) {
+                        error = pos;
+                        return nullptr;
+                    }
+
+                    pos = span = next;
+                }
+            }
+        };
+
+        const char *skipString(const char *pos, const char *end) {
+            for (++pos; ; ) {
+                pos = findSpecial<false>(pos, end);
+
+                if (pos == end) {
+                    return nullptr;
+                }
+
+                if (*pos == '"') {
+                    return pos + 1;
+                }
+
+                // skip the escaped character
+                if (end - pos < 2) {
+                    return nullptr;
+                }
+
+                pos += 2;
+            }
+        }
+
+        const char *validateString(const char *pos, const char *end, const char *&error) {
+            return scanString<std::string>(pos, end, nullptr, error);
+        }
+
+        const char *decodeString(const char *pos, const char *end, std::string &output, const char *&error) {
+            return scanString(pos, end, &output, error);
+        }
+
+        const char *decodeString(const char *pos, const char *end, std::pmr::string &output, const char *&error) {
+            return scanString(pos, end, &output, error);
+        }
+    };
+};
@@ -0,0 +1,177 @@
+#include "json.hpp"
+#include "scanner.hpp"
+
+namespace JSON {
+
+    namespace {
+
+        // one bit per nesting level, set for Objects
+        class ContainerStack {
+            public:
+                bool push(bool object) {
+                    if (depth == MAX_VALIDATION_DEPTH) {
+                        return false;
+                    }
+
+                    std::uint64_t bit = 1ULL << (depth % 64);
+                    std::uint64_t &word = bits[depth / 64];
+                    word = object ? (word | bit) : (word & ~bit);
+                    ++depth;
+
+                    return true;
+                }
+
+                void pop() { --depth; }
+                bool empty() const { return depth == 0; }
+
+                bool topIsObject() const {
+                    std::size_t top = depth - 1;
+                    return (bits[top / 64] >> (top % 64)) & 1;
+                }
+
+            private:
+                std::uint64_t bits[MAX_VALIDATION_DEPTH / 64];
+                std::size_t depth = 0;
+        };
+    };
+
+    Validation validate(const char *data, std::size_t size) {
+        const char *pos = data;
+        const char *end = data + size;
+        const char *error = nullptr;
+        ContainerStack stack;
+
+        auto fail = [&](const char *at) {
+            return Validation{ false, (std::size_t)(at - data) };
+        };
+
+        while (true) {
+            // a value is expected at pos
+            pos = Scanner::skipWhitespace(pos, end);
+
+            if (pos == end) {
+                return fail(pos);
+            }
+
+            const char *next = nullptr;
+
+            switch (*pos) {
+                case '{':
+                case '[': {
+                    bool object = (*pos == '{');
+
+                    if (!stack.push(object)) {
+                        return fail(pos);
+                    }
+
+                    pos = Scanner::skipWhitespace(pos + 1, end);
+
+                    if (pos != end && *pos == (object ? '}' : ']')) {
+                        stack.pop();
+                        next = pos + 1;
+                        break;
+                    }
+
+                    if (!object) {
+                        continue;
+                    }
+
+                    // the first member name
+                    if (pos == end || *pos != '"') {
+                        return fail(pos);
+                    }
+
+                    pos = Scanner::validateString(pos, end, error);
+
+                    if (pos == nullptr) {
+                        return fail(error);
+                    }
+
+                    pos = Scanner::skipWhitespace(pos, end);
+
+                    if (pos == end || *pos != ':') {
+                        return fail(pos);
+                    }
+
+                    ++pos;
+                } continue;
+
+                case '"': {
+                    next = Scanner::validateString(pos, end, error);
+                } break;
+
+                case 't': {
+                    next = Scanner::validateLiteral(pos, end, "true", 4, error);
+                } break;
+
+                case 'f': {
+                    next = Scanner::validateLiteral(pos, end, "false", 5, error);
+                } break;
+
+                case 'n': {
+                    next = Scanner::validateLiteral(pos, end, "null", 4, error);
+                } break;
+
+                default: {
+                    next = Scanner::validateNumber(pos, end, error);
+                } break;
+            }
+
+            if (next == nullptr) {
+                return fail(error);
+            }
+
+            // a value ended, close containers until one continues
+            pos = next;
+
+            while (true) {
+                pos = Scanner::skipWhitespace(pos, end);
+
+                if (stack.empty()) {
+                    return pos == end ? Validation{ true, size } : fail(pos);
+                }
+
+                if (pos == end) {
+                    return fail(pos);
+                }
+
+                bool object = stack.topIsObject();
+
+                if (*pos == (object ? '}' : ']')) {
+                    stack.pop();
+                    ++pos;
+                    continue;
+                }
+
+                if (*pos != ',') {
+                    return fail(pos);
+                }
+
+                pos = Scanner::skipWhitespace(pos + 1, end);
+
+                if (object) {
+                    if (pos == end || *pos != '"') {
+                        return fail(pos);
+                    }
+
+                    pos = Scanner::validateString(pos, end, error);
+
+                    if (pos == nullptr) {
+                        return fail(error);
+                    }
+
+                    pos = Scanner::skipWhitespace(pos, end);
+
+                    if (pos == end || *pos != ':') {
+                        return fail(pos);
+                    }
+
+                    ++pos;
+                }
+
+                break;
+            }
+        }
+    }
+
+}; // namespace JSON
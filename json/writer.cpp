@@ -0,0 +1,302 @@
+#include <stdexcept>
+
+#include "writer.hpp"
+
+namespace JSON {
+
+    Writer::Writer(std::pmr::memory_resource *resource)
+        : resource(resource == nullptr ? Memory::defaultResource() : resource), output(nullptr), complete(false)
+    {
+    }
+
+    Writer::Writer(std::ostream &output)
+        : resource(Memory::defaultResource()), output(&output), complete(false)
+    {
+    }
+
+    Writer &Writer::beginArray(std::size_t reserve) {
+        open(false, reserve, "Writer::beginArray");
+        return *this;
+    }
+
+    Writer &Writer::beginObject(std::size_t reserve) {
+        open(true, reserve, "Writer::beginObject");
+        return *this;
+    }
+
+    Writer &Writer::endArray() {
+        close(false, "Writer::endArray");
+        return *this;
+    }
+
+    Writer &Writer::endObject() {
+        close(true, "Writer::endObject");
+        return *this;
+    }
+
+    Writer &Writer::key(const char *name) {
+        return key(std::string_view(name));
+    }
+
+    Writer &Writer::key(std::string_view name) {
+        if (frames.empty() || !frames.back().object || frames.back().keyed) {
+            throw std::logic_error("Writer::key: no Object is waiting for a name");
+        }
+
+        Frame &frame = frames.back();
+
+        if (output != nullptr) {
+            *output << '\t' << name << ": ";
+        } else {
+            frame.name.assign(name);
+        }
+
+        frame.keyed = true;
+
+        return *this;
+    }
+
+    Writer &Writer::key(std::pmr::string &&name) {
+        if (output != nullptr) {
+            return key(std::string_view(name));
+        }
+
+        if (frames.empty() || !frames.back().object || frames.back().keyed) {
+            throw std::logic_error("Writer::key: no Object is waiting for a name");
+        }
+
+        // moved when it comes from the same resource
+        frames.back().name = std::move(name);
+        frames.back().keyed = true;
+
+        return *this;
+    }
+
+    Writer &Writer::value(std::nullptr_t null) {
+        expectValue("Writer::value");
+
+        if (output != nullptr) {
+            *output << "null";
+            separate();
+        } else {
+            Json json;
+            json = nullptr;
+            place(std::move(json));
+        }
+
+        return *this;
+    }
+
+    Writer &Writer::value(bool boolean) {
+        expectValue("Writer::value");
+
+        if (output != nullptr) {
+            *output << (boolean ? "true" : "false");
+            separate();
+        } else {
+            Json json;
+            json = boolean;
+            place(std::move(json));
+        }
+
+        return *this;
+    }
+
+    Writer &Writer::value(int integer) {
+        return value((long long)integer);
+    }
+
+    Writer &Writer::value(long integer) {
+        return value((long long)integer);
+    }
+
+    Writer &Writer::value(long long integer) {
+        expectValue("Writer::value");
+
+        if (output != nullptr) {
+            *output << integer;
+            separate();
+        } else {
+            Json json;
+            json = integer;
+            place(std::move(json));
+        }
+
+        return *this;
+    }
+
+    Writer &Writer::value(unsigned long long integer) {
+        expectValue("Writer::value");
+
+        if (output != nullptr) {
+            *output << integer;
+            separate();
+        } else {
+            Json json;
+            json = integer;
+            place(std::move(json));
+        }
+
+        return *this;
+    }
+
+    Writer &Writer::value(double floatingPoint) {
+        expectValue("Writer::value");
+
+        // a Json assigned a double writes it as a long double
+        if (output != nullptr) {
+            *output << (long double)floatingPoint;
+            separate();
+        } else {
+            Json json;
+            json = floatingPoint;
+            place(std::move(json));
+        }
+
+        return *this;
+    }
+
+    Writer &Writer::value(const char *string) {
+        return value(std::string_view(string));
+    }
+
+    Writer &Writer::value(std::string_view string) {
+        expectValue("Writer::value");
+
+        if (output != nullptr) {
+            *output << string;
+            separate();
+        } else {
+            Json json;
+            json.type = Json::Type::String;
+            json.value = Json::allocate<Json::Text>(resource, string);
+            place(std::move(json));
+        }
+
+        return *this;
+    }
+
+    Writer &Writer::value(std::pmr::string &&string) {
+        if (output != nullptr) {
+            return value(std::string_view(string));
+        }
+
+        expectValue("Writer::value");
+
+        // the node takes the resource of the writer, so the buffer is
+        // moved when it comes from the same one and copied otherwise
+        Json json;
+        json.type = Json::Type::String;
+        json.value = Json::allocate<Json::Text>(resource, std::move(string));
+        place(std::move(json));
+
+        return *this;
+    }
+
+    Writer &Writer::value(const Json &json) {
+        expectValue("Writer::value");
+
+        if (output != nullptr) {
+            *output << json;
+            separate();
+        } else {
+            place(Json(json));
+        }
+
+        return *this;
+    }
+
+    Json Writer::result() {
+        if (output != nullptr || !complete) {
+            throw std::logic_error("Writer::result: no Json value was built");
+        }
+
+        Json json = std::move(root);
+        root = Json();
+        complete = false;
+
+        return json;
+    }
+
+    void Writer::open(bool object, std::size_t reserve, const char *caller) {
+        expectValue(caller);
+
+        if (output != nullptr) {
+            *output << (object ? "\n{\n" : "[ ");
+            frames.push_back({ object, false, Json(), std::pmr::string() });
+            return;
+        }
+
+        Json container(object ? Json::Type::Object : Json::Type::Array, resource);
+
+        if (object) {
+            std::get<Json::Type::Object>(container.value)->reserve(reserve);
+        } else {
+            std::get<Json::Type::Array>(container.value)->reserve(reserve);
+        }
+
+        frames.push_back({ object, false, std::move(container), std::pmr::string(resource) });
+    }
+
+    void Writer::close(bool object, const char *caller) {
+        if (frames.empty() || frames.back().object != object || frames.back().keyed) {
+            throw std::logic_error(std::string(caller) + ": the innermost container can not be closed");
+        }
+
+        Json container = std::move(frames.back().container);
+        frames.pop_back();
+
+        if (output != nullptr) {
+            *output << (object ? "}\n" : "]");
+            separate();
+        } else {
+            place(std::move(container));
+        }
+    }
+
+    void Writer::expectValue(const char *caller) const {
+        if (complete) {
+            throw std::logic_error(std::string(caller) + ": the value is already complete");
+        }
+
+        if (!frames.empty() && frames.back().object && !frames.back().keyed) {
+            throw std::logic_error(std::string(caller) + ": a member needs a key first");
+        }
+    }
+
+    void Writer::place(Json &&json) {
+        if (frames.empty()) {
+            root = std::move(json);
+            complete = true;
+            return;
+        }
+
+        Frame &frame = frames.back();
+
+        if (frame.object) {
+            // the last of duplicate names wins, like in the parser
+            std::get<Json::Type::Object>(frame.container.value)->insert_or_assign(std::move(frame.name), std::move(json));
+            frame.name.clear();
+            frame.keyed = false;
+        } else {
+            std::get<Json::Type::Array>(frame.container.value)->push_back(std::move(json));
+        }
+    }
+
+    void Writer::separate() {
+        if (frames.empty()) {
+            complete = true;
+            return;
+        }
+
+        Frame &frame = frames.back();
+
+        if (frame.object) {
+            *output << ",\n";
+            frame.keyed = false;
+        } else {
+            *output << ", ";
+        }
+    }
+
+}; // namespace JSON
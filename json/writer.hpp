@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "json.hpp"
+
+namespace JSON {
+
+    /**
+     * Writes a document one call at a time, either into a Json tree or
+     * straight to a stream as the text operator<< would write for that
+     * tree, without building it.
+     *
+     *     writer.beginObject(2).key("id").value(7)
+     *           .key("tags").beginArray().value("a").endArray()
+     *           .endObject();
+     *
+     * Containers are created with the capacity they are told they need,
+     * values go into them in place and strings passed as std::pmr::string
+     * rvalues are moved rather than copied. Members of streamed Objects
+     * are written in the order they are given.
+     *
+     * Calls out of order, like a value in an Object without a key, throw
+     * std::logic_error and leave the writer unchanged.
+     * */
+    class Writer {
+        public:
+            /**
+             * This constructor makes a writer that builds a Json value
+             *
+             * @param[in] resource
+             *     Where the nodes are allocated, nullptr for
+             *     Memory::defaultResource().
+             * */
+            explicit Writer(std::pmr::memory_resource *resource = nullptr);
+
+            // this one writes text to output as the calls come in
+            explicit Writer(std::ostream &output);
+
+            /**
+             * These methods open a container, reserving room for the
+             * given number of elements or members when building a tree
+             * */
+            Writer &beginArray(std::size_t reserve = 0);
+            Writer &beginObject(std::size_t reserve = 0);
+            Writer &endArray();
+            Writer &endObject();
+
+            // the name of the next member of the innermost Object
+            Writer &key(const char *name);
+            Writer &key(std::string_view name);
+            Writer &key(std::pmr::string &&name);
+
+            Writer &value(std::nullptr_t null);
+            Writer &value(bool boolean);
+            Writer &value(int integer);
+            Writer &value(long integer);
+            Writer &value(long long integer);
+            Writer &value(unsigned long long integer);
+            Writer &value(double floatingPoint);
+            Writer &value(const char *string);
+            Writer &value(std::string_view string);
+            Writer &value(std::pmr::string &&string);
+
+            // a whole subtree, whose containers are shared, not copied
+            Writer &value(const Json &json);
+
+            // whether a complete value has been written
+            bool done() const { return complete; }
+
+            /**
+             * This method hands over the Json value that was built and
+             * readies the writer for the next one
+             *
+             * @throw std::logic_error
+             *     If the value is not complete or the writer streams.
+             * */
+            Json result();
+
+        private:
+            struct Frame {
+                bool object;
+                bool keyed;
+
+                // unused while streaming
+                Json container;
+                std::pmr::string name;
+            };
+
+            void open(bool object, std::size_t reserve, const char *caller);
+            void close(bool object, const char *caller);
+
+            // checks that a value may come next
+            void expectValue(const char *caller) const;
+
+            // puts a finished value into the innermost container
+            void place(Json &&json);
+
+            // writes what follows a finished value in the innermost container
+            void separate();
+
+        private:
+            std::pmr::memory_resource *resource;
+            std::ostream *output;
+
+            std::vector<Frame> frames;
+            Json root;
+            bool complete;
+    };
+
+}; // namespace JSON
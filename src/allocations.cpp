@@ -0,0 +1,84 @@
+#include <cstdlib>
+#include <new>
+
+#include "allocations.hpp"
+
+namespace {
+
+    thread_local Allocations::Usage usage;
+
+    void *allocate(std::size_t size, std::size_t alignment) {
+        usage.allocations++;
+        usage.bytes += size;
+
+        if (size == 0) {
+            size = 1;
+        }
+
+        void *pointer = nullptr;
+
+        if (alignment <= alignof(std::max_align_t)) {
+            pointer = std::malloc(size);
+        } else {
+            // aligned_alloc wants a multiple of the alignment
+            pointer = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+        }
+
+        if (pointer == nullptr) {
+            throw std::bad_alloc();
+        }
+
+        return pointer;
+    }
+};
+
+namespace Allocations {
+
+    Usage total() {
+        return usage;
+    }
+};
+
+// every form is replaced, a sanitizer runtime would supply the others
+void *operator new(std::size_t size) {
+    return allocate(size, alignof(std::max_align_t));
+}
+
+void *operator new[](std::size_t size) {
+    return allocate(size, alignof(std::max_align_t));
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+    return allocate(size, (std::size_t)alignment);
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+    return allocate(size, (std::size_t)alignment);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    try {
+        return allocate(size, alignof(std::max_align_t));
+    } catch (const std::bad_alloc &) {
+        return nullptr;
+    }
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    try {
+        return allocate(size, alignof(std::max_align_t));
+    } catch (const std::bad_alloc &) {
+        return nullptr;
+    }
+}
+
+void operator delete(void *pointer) noexcept { std::free(pointer); }
+void operator delete[](void *pointer) noexcept { std::free(pointer); }
+void operator delete(void *pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete[](void *pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete(void *pointer, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete[](void *pointer, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete(void *pointer, std::size_t, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete[](void *pointer, std::size_t, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete(void *pointer, const std::nothrow_t &) noexcept { std::free(pointer); }
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept { std::free(pointer); }
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+ * Counts the heap allocations made by the calling thread.
+ *
+ * Linking allocations.cpp replaces the global operator new and operator
+ * delete with versions that keep a running total per thread, so a test
+ * can compare the allocations of an API call against a fixed budget.
+ * Unlike timings the totals are the same on every run of a build.
+ * */
+namespace Allocations {
+
+    struct Usage {
+        std::size_t allocations = 0;
+        std::size_t bytes = 0;
+    };
+
+    // the totals of the calling thread since it started
+    Usage total();
+
+    /**
+     * This function calls f and returns what it allocated on the
+     * calling thread, memory it frees again is still counted
+     * */
+    template<typename F>
+    Usage measure(F &&f) {
+        Usage before = total();
+        f();
+        Usage after = total();
+
+        return { after.allocations - before.allocations, after.bytes - before.bytes };
+    }
+};
@@ -0,0 +1,367 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string_view>
+#include <thread>
+
+#include <decompress.hpp>
+
+#include "batch.hpp"
+#include "ingest.hpp"
+#include "pool.hpp"
+
+namespace fs = std::filesystem;
+
+namespace Batch {
+
+    namespace {
+
+        using Clock = std::chrono::steady_clock;
+
+        // per-worker totals
+        struct Worker {
+            std::size_t files = 0;
+            std::uintmax_t bytes = 0;
+        };
+
+        const char *typeName(JSON::Json::Type type) {
+            switch (type) {
+                case JSON::Json::Type::Boolean: return "boolean";
+                case JSON::Json::Type::Integer: return "integer";
+                case JSON::Json::Type::FloatingPoint: return "number";
+                case JSON::Json::Type::String: return "string";
+                case JSON::Json::Type::Array: return "array";
+                case JSON::Json::Type::Object: return "object";
+                case JSON::Json::Type::Null: return "null";
+                default: return "invalid";
+            }
+        }
+
+        // a compressed document is decompressed on the way, a top-level
+        // Array is counted element by element without holding its text,
+        // anything else is gathered whole and parsed
+        void parseCompressed(std::string_view input, FileResult &result) {
+            JSON::ChunkReader source = [input](char *buffer, std::size_t capacity) mutable {
+                std::size_t count = std::min(capacity, input.size());
+                input.copy(buffer, count);
+                input.remove_prefix(count);
+                return count;
+            };
+
+            JSON::ChunkReader reader = JSON::decompressing(std::move(source));
+            std::string head;
+            std::size_t start = 0;
+            bool failed = false;
+
+            // read until the first byte that is not whitespace tells the type
+            while (start == head.size()) {
+                char chunk[4096];
+                std::size_t count = reader(chunk, sizeof(chunk));
+
+                if (count == 0 || count == JSON::READ_FAILED) {
+                    failed = (count == JSON::READ_FAILED);
+                    break;
+                }
+
+                head.append(chunk, count);
+                start = head.find_first_not_of(" \t\n\r");
+                start = start == std::string::npos ? head.size() : start;
+            }
+
+            result.bytes = head.size();
+
+            if (failed || start == head.size()) {
+                result.status = FileResult::Invalid;
+                return;
+            }
+
+            if (head[start] == '[') {
+                std::size_t served = 0;
+                JSON::ChunkReader rest = [&](char *buffer, std::size_t capacity) {
+                    if (served < head.size()) {
+                        std::size_t count = head.copy(buffer, capacity, served);
+                        served += count;
+                        return count;
+                    }
+
+                    std::size_t count = reader(buffer, capacity);
+
+                    if (count != JSON::READ_FAILED) {
+                        result.bytes += count;
+                    }
+
+                    return count;
+                };
+
+                result.type = JSON::Json::Type::Array;
+                result.status = FileResult::Parsed;
+
+                for (auto &element : JSON::elements(std::move(rest))) {
+                    if (element.isInvalid()) {
+                        result.type = JSON::Json::Type::Invalid;
+                        result.status = FileResult::Invalid;
+                        break;
+                    }
+
+                    result.size++;
+                }
+
+                return;
+            }
+
+            for (;;) {
+                std::size_t offset = head.size();
+                head.resize(offset + 64 * 1024);
+                std::size_t count = reader(head.data() + offset, 64 * 1024);
+                head.resize(offset + (count == JSON::READ_FAILED ? 0 : count));
+
+                if (count == 0 || count == JSON::READ_FAILED) {
+                    failed = (count == JSON::READ_FAILED);
+                    break;
+                }
+            }
+
+            result.bytes = head.size();
+
+            if (failed) {
+                result.status = FileResult::Invalid;
+                return;
+            }
+
+            JSON::Json *json = JSON::Json::fromCppString(head);
+
+            result.type = json->getType();
+            result.status = json->isInvalid() ? FileResult::Invalid : FileResult::Parsed;
+
+            if (json->isArray() || json->isObject() || json->isString()) {
+                result.size = json->size();
+            }
+
+            delete json;
+        }
+
+        // .json files, compressed or not
+        bool isJsonFile(const fs::path &path) {
+            fs::path extension = path.extension();
+
+            if (extension == ".gz" || extension == ".zst") {
+                extension = path.stem().extension();
+            }
+
+            return extension == ".json";
+        }
+
+        void addListed(std::istream &list, std::vector<fs::path> &files) {
+            std::string line;
+
+            while (std::getline(list, line)) {
+                if (!line.empty() && line.back() == '\r') {
+                    line.pop_back();
+                }
+
+                if (!line.empty()) {
+                    files.emplace_back(line);
+                }
+            }
+        }
+    };
+
+    std::vector<fs::path> collect(const std::vector<fs::path> &inputs, const std::string &fileList) {
+        std::vector<fs::path> files;
+
+        for (const auto &input : inputs) {
+            std::error_code error;
+
+            if (!fs::is_directory(input, error)) {
+                files.push_back(input);
+                continue;
+            }
+
+            auto options = fs::directory_options::skip_permission_denied;
+            std::size_t first = files.size();
+
+            for (fs::recursive_directory_iterator it{ input, options, error }, end; it != end; it.increment(error)) {
+                if (error) {
+                    break;
+                }
+
+                std::error_code fileError;
+
+                if (it->is_regular_file(fileError) && isJsonFile(it->path())) {
+                    files.push_back(it->path());
+                }
+            }
+
+            // directory order is arbitrary, report in a stable one
+            std::sort(files.begin() + (std::ptrdiff_t)first, files.end());
+        }
+
+        if (fileList == "-") {
+            addListed(std::cin, files);
+        } else if (!fileList.empty()) {
+            std::ifstream list{ fileList };
+            addListed(list, files);
+        }
+
+        return files;
+    }
+
+    std::vector<FileResult> parse(const std::vector<fs::path> &files, const Options &options, Statistics *statistics) {
+        std::vector<FileResult> results(files.size());
+        std::vector<std::size_t> order(files.size());
+
+        for (std::size_t i = 0; i < files.size(); ++i) {
+            std::error_code error;
+            results[i].path = files[i];
+            results[i].bytes = fs::file_size(files[i], error);
+
+            if (error) {
+                results[i].bytes = 0;
+            }
+
+            order[i] = i;
+        }
+
+        // largest first, so a huge file is never the last one to start
+        std::stable_sort(order.begin(), order.end(), [&results](std::size_t a, std::size_t b) {
+            return results[a].bytes > results[b].bytes;
+        });
+
+        std::size_t jobs = options.jobs != 0 ? options.jobs : std::thread::hardware_concurrency();
+        WorkStealingPool pool{ std::min<std::size_t>(std::max<std::size_t>(jobs, 1), std::max<std::size_t>(files.size(), 1)) };
+        std::vector<Worker> workers(pool.size());
+        std::vector<Ingest::Buffer *> loaded(files.size());
+        Ingest ingest{ options.readAhead, pool.size(), options.ioUring };
+
+        pool.start([&](std::size_t index, std::size_t worker) {
+            FileResult &result = results[index];
+            Worker &state = workers[worker];
+            Ingest::Buffer *buffer = loaded[index];
+            auto start = Clock::now();
+
+            // compressed files are decompressed by the worker that parses them
+            if (buffer->ok && JSON::detectCodec(buffer->data) != JSON::Codec::Plain) {
+                parseCompressed(buffer->data, result);
+            } else if (buffer->ok) {
+                const std::string &data = buffer->data;
+                JSON::Json *json = JSON::Json::fromCppString(data);
+
+                result.bytes = data.size();
+                result.type = json->getType();
+                result.status = json->isInvalid() ? FileResult::Invalid : FileResult::Parsed;
+
+                if (json->isArray() || json->isObject() || json->isString()) {
+                    result.size = json->size();
+                }
+
+                delete json;
+            }
+
+            ingest.recycle(buffer);
+
+            result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            state.files++;
+            state.bytes += result.bytes;
+        });
+
+        // the pool's queues order each push before the worker that takes it
+        ingest.read(files, order, [&](Ingest::Buffer *buffer) {
+            loaded[buffer->index] = buffer;
+            pool.push(buffer->index);
+        });
+
+        pool.finish();
+
+        if (statistics != nullptr) {
+            statistics->steals = pool.steals();
+            statistics->ioUring = (ingest.backend() == Ingest::IoUring);
+            statistics->files.clear();
+            statistics->bytes.clear();
+
+            for (const auto &worker : workers) {
+                statistics->files.push_back(worker.files);
+                statistics->bytes.push_back(worker.bytes);
+            }
+        }
+
+        return results;
+    }
+
+    int run(
+        const std::vector<fs::path> &inputs,
+        const std::string &fileList,
+        const Options &options,
+        std::ostream &out)
+    {
+        auto start = Clock::now();
+        std::vector<fs::path> files = collect(inputs, fileList);
+        Statistics statistics;
+        std::vector<FileResult> results = parse(files, options, &statistics);
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::size_t parsed = 0;
+        std::size_t invalid = 0;
+        std::size_t unreadable = 0;
+        std::uintmax_t bytes = 0;
+
+        for (const auto &result : results) {
+            bytes += result.bytes;
+
+            switch (result.status) {
+                case FileResult::Parsed: {
+                    parsed++;
+                } break;
+
+                case FileResult::Invalid: {
+                    invalid++;
+                } break;
+
+                case FileResult::Unreadable: {
+                    unreadable++;
+                } break;
+            }
+
+            if (options.quiet) {
+                continue;
+            }
+
+            out << result.path.string() << ": ";
+
+            if (result.status == FileResult::Unreadable) {
+                out << "unreadable" << std::endl;
+                continue;
+            }
+
+            out << typeName(result.type);
+
+            if (result.status == FileResult::Parsed) {
+                out << "(" << result.size << ")";
+            }
+
+            out << ", " << result.bytes << " bytes, " << result.seconds * 1000 << " ms" << std::endl;
+        }
+
+        double mebibytes = (double)bytes / (1024 * 1024);
+
+        out << std::endl;
+        out << "Files: " << results.size()
+            << " (" << parsed << " parsed, " << invalid << " invalid, " << unreadable << " unreadable)" << std::endl;
+        out << "Bytes: " << bytes << std::endl;
+        out << "Time: " << seconds << " s" << std::endl;
+
+        if (seconds > 0) {
+            out << "Throughput: " << mebibytes / seconds << " MiB/s, "
+                << (double)results.size() / seconds << " files/s" << std::endl;
+        }
+
+        out << "Reads: " << (statistics.ioUring ? "io_uring" : "pread") << std::endl;
+        out << "Workers: " << statistics.files.size() << " (" << statistics.steals << " tasks stolen)" << std::endl;
+
+        for (std::size_t i = 0; i < statistics.files.size(); ++i) {
+            out << "  #" << i << ": " << statistics.files[i] << " files, " << statistics.bytes[i] << " bytes" << std::endl;
+        }
+
+        return (invalid == 0 && unreadable == 0) ? 0 : -5;
+    }
+};
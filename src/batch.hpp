@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <json.hpp>
+
+/**
+ * Batch mode of the parser executable: parses many files on all cores
+ * and reports a line per file and a throughput summary.
+ * */
+namespace Batch {
+
+    struct Options {
+        std::size_t jobs = 0;   // 0 means one worker per hardware thread
+        bool quiet = false;     // only print the summary
+        std::size_t readAhead = 64; // reads in flight ahead of the workers
+        bool ioUring = true;    // false forces pread() reads
+    };
+
+    struct FileResult {
+        enum Status {
+            Parsed,
+            Invalid,
+            Unreadable
+        };
+
+        std::filesystem::path path;
+        std::uintmax_t bytes = 0;
+        Status status = Unreadable;
+        JSON::Json::Type type = JSON::Json::Type::Invalid;
+        std::size_t size = 0;   // elements, members or characters of the root
+        double seconds = 0;     // time spent parsing
+    };
+
+    // how the work was spread over the workers
+    struct Statistics {
+        std::size_t steals = 0;
+        bool ioUring = false;                   // which backend read the files
+        std::vector<std::size_t> files;         // per worker
+        std::vector<std::uintmax_t> bytes;      // per worker
+    };
+
+    /**
+     * This function expands the inputs into the list of files to parse,
+     * directories are searched recursively for .json files, and for
+     * .json.gz and .json.zst files
+     *
+     * @param[in] inputs
+     *     Files and directories named on the command line.
+     *
+     * @param[in] fileList
+     *     A file with one path per line, "-" for the standard input,
+     *     or an empty string for none.
+     * */
+    std::vector<std::filesystem::path> collect(
+        const std::vector<std::filesystem::path> &inputs,
+        const std::string &fileList);
+
+    /**
+     * This function parses every file and returns the results in the
+     * order of the files
+     * */
+    std::vector<FileResult> parse(
+        const std::vector<std::filesystem::path> &files,
+        const Options &options,
+        Statistics *statistics = nullptr);
+
+    /**
+     * This function runs the whole batch and prints its report
+     *
+     * @return
+     *     0 if every file parsed, -5 otherwise
+     * */
+    int run(
+        const std::vector<std::filesystem::path> &inputs,
+        const std::string &fileList,
+        const Options &options,
+        std::ostream &out);
+};
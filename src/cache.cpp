@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <vector>
+
+#include <hash.hpp>
+
+#include "cache.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    // entry layout: magic, payload checksum, payload
+    constexpr char MAGIC[8] = { 'J', 'S', 'O', 'N', 'C', 'A', 'C', '1' };
+    constexpr std::size_t HEADER_SIZE = sizeof(MAGIC) + sizeof(std::uint64_t);
+
+    bool readFile(const fs::path &path, std::string &content) {
+        std::ifstream file{ path, std::ios::binary };
+
+        if (!file.is_open()) {
+            return false;
+        }
+
+        file.seekg(0, std::ios::end);
+        std::streamoff size = file.tellg();
+
+        if (size < 0) {
+            return false;
+        }
+
+        content.resize((std::size_t)size);
+        file.seekg(0, std::ios::beg);
+        file.read(content.data(), size);
+
+        return (bool)file;
+    }
+};
+
+DocumentCache::DocumentCache(const fs::path &directory, std::uintmax_t capacity)
+    : directory(directory), capacity(capacity)
+{
+    std::error_code error;
+    fs::create_directories(directory, error);
+}
+
+fs::path DocumentCache::entryPath(const std::string &content, fs::file_time_type modified) const {
+    char name[96];
+    std::snprintf(
+        name, sizeof(name), "%016llx-%llx-%llx.jbin",
+        (unsigned long long)JSON::Hash::xxh64(content.data(), content.size()),
+        (unsigned long long)content.size(),
+        (unsigned long long)modified.time_since_epoch().count());
+
+    return directory / name;
+}
+
+JSON::Json *DocumentCache::load(const std::string &content, fs::file_time_type modified) {
+    fs::path path = entryPath(content, modified);
+    std::string entry;
+
+    // a concurrent eviction may remove the entry at any point,
+    // which is just a miss
+    if (!readFile(path, entry) || entry.size() < HEADER_SIZE) {
+        return nullptr;
+    }
+
+    if (std::memcmp(entry.data(), MAGIC, sizeof(MAGIC)) != 0) {
+        return nullptr;
+    }
+
+    std::uint64_t checksum;
+    std::memcpy(&checksum, entry.data() + sizeof(MAGIC), sizeof(checksum));
+    const char *payload = entry.data() + HEADER_SIZE;
+    std::size_t payloadSize = entry.size() - HEADER_SIZE;
+
+    if (JSON::Hash::xxh64(payload, payloadSize) != checksum) {
+        return nullptr;
+    }
+
+    JSON::Json *json = JSON::Json::fromBinary(payload, payloadSize);
+
+    if (json->isInvalid()) {
+        delete json;
+        return nullptr;
+    }
+
+    // the modification time of an entry is its LRU timestamp
+    std::error_code error;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), error);
+
+    return json;
+}
+
+void DocumentCache::store(const std::string &content, fs::file_time_type modified, const JSON::Json &json) {
+    std::string payload = json.toBinary();
+    std::uint64_t checksum = JSON::Hash::xxh64(payload.data(), payload.size());
+
+    fs::path path = entryPath(content, modified);
+    fs::path temporary = path;
+    temporary += ".tmp" + std::to_string(std::random_device{}());
+
+    {
+        std::ofstream file{ temporary, std::ios::binary | std::ios::trunc };
+
+        if (!file.is_open()) {
+            return;
+        }
+
+        file.write(MAGIC, sizeof(MAGIC));
+        file.write((const char *)&checksum, sizeof(checksum));
+        file.write(payload.data(), (std::streamsize)payload.size());
+
+        if (!file) {
+            file.close();
+            std::error_code error;
+            fs::remove(temporary, error);
+            return;
+        }
+    }
+
+    // readers only ever see complete entries
+    std::error_code error;
+    fs::rename(temporary, path, error);
+
+    if (error) {
+        fs::remove(temporary, error);
+        return;
+    }
+
+    evict();
+}
+
+void DocumentCache::evict() {
+    struct Entry {
+        fs::path path;
+        fs::file_time_type used;
+        std::uintmax_t size;
+    };
+
+    std::vector<Entry> entries;
+    std::uintmax_t total = 0;
+    std::error_code error;
+
+    for (const auto &file : fs::directory_iterator(directory, error)) {
+        std::error_code fileError;
+
+        // temporary files belong to writers that have not renamed yet
+        if (!file.is_regular_file(fileError) || file.path().extension() != ".jbin") {
+            continue;
+        }
+
+        Entry entry{ file.path(), file.last_write_time(fileError), file.file_size(fileError) };
+
+        if (fileError) {
+            continue;
+        }
+
+        total += entry.size;
+        entries.push_back(std::move(entry));
+    }
+
+    if (total <= capacity) {
+        return;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+        return a.used < b.used;
+    });
+
+    for (const auto &entry : entries) {
+        if (total <= capacity) {
+            break;
+        }
+
+        // another process may have removed it already
+        fs::remove(entry.path, error);
+        total -= entry.size;
+    }
+}
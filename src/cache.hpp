@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+#include <json.hpp>
+
+/**
+ * On-disk cache of parsed documents for the parser executable.
+ *
+ * Entries are keyed by the xxHash of the file content together with
+ * its size and modification time, and hold the document in the binary
+ * form of Json::toBinary(). Entries are published with an atomic rename
+ * so several processes can share one directory, and the least recently
+ * used entries are evicted once the directory grows past its capacity.
+ * */
+class DocumentCache {
+    public:
+        DocumentCache(const std::filesystem::path &directory, std::uintmax_t capacity);
+
+        /**
+         * This method looks up the parsed document for a file
+         *
+         * @param[in] content
+         *     The content of the file.
+         *
+         * @param[in] modified
+         *     The last write time of the file.
+         *
+         * @return
+         *     A pointer to the cached Json value, or nullptr on a miss
+         * */
+        JSON::Json *load(const std::string &content, std::filesystem::file_time_type modified);
+
+        /**
+         * This method stores the parsed document for a file and evicts
+         * old entries if the cache exceeds its capacity
+         * */
+        void store(
+            const std::string &content,
+            std::filesystem::file_time_type modified,
+            const JSON::Json &json);
+
+    private:
+        std::filesystem::path entryPath(
+            const std::string &content,
+            std::filesystem::file_time_type modified) const;
+        void evict();
+
+    private:
+        std::filesystem::path directory;
+        std::uintmax_t capacity;
+};
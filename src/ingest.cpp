@@ -0,0 +1,479 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <system_error>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define JSON_PARSER_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+#include "ingest.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    // the most bytes asked for in one read, larger files take several
+    constexpr std::size_t MAX_READ = 1 << 30;
+
+    // the most threads the pread() backend starts
+    constexpr std::size_t MAX_PREAD_THREADS = 16;
+
+    /**
+     * Opens a regular file for reading
+     *
+     * @return
+     *     The file descriptor, or -1
+     * */
+    int openFile(const fs::path &path, std::size_t &size) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+        if (fd < 0) {
+            return -1;
+        }
+
+        struct stat status;
+
+        if (::fstat(fd, &status) != 0 || !S_ISREG(status.st_mode)) {
+            ::close(fd);
+            return -1;
+        }
+
+        size = (std::size_t)status.st_size;
+        return fd;
+    }
+
+#if defined(JSON_PARSER_IO_URING)
+    /**
+     * A minimal io_uring over the raw system calls: one submission and
+     * one completion queue shared with the kernel through mmap()
+     * */
+    class Ring {
+        public:
+            explicit Ring(unsigned entries) {
+                io_uring_params params;
+                std::memset(&params, 0, sizeof(params));
+
+                fd = (int)::syscall(__NR_io_uring_setup, entries, &params);
+
+                if (fd < 0) {
+                    return;
+                }
+
+                sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+                cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+                bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+
+                if (single) {
+                    sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+                }
+
+                sqRing = ::mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+                cqRing = single ? sqRing : ::mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+                sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+                void *sqesMap = ::mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+
+                if (sqRing == MAP_FAILED || cqRing == MAP_FAILED || sqesMap == MAP_FAILED) {
+                    if (sqesMap != MAP_FAILED) {
+                        ::munmap(sqesMap, sqesSize);
+                    }
+
+                    release();
+                    return;
+                }
+
+                char *sq = (char *)sqRing;
+                char *cq = (char *)cqRing;
+
+                sqHead = (unsigned *)(sq + params.sq_off.head);
+                sqTail = (unsigned *)(sq + params.sq_off.tail);
+                sqMask = *(unsigned *)(sq + params.sq_off.ring_mask);
+                sqEntries = params.sq_entries;
+                sqArray = (unsigned *)(sq + params.sq_off.array);
+                sqes = (io_uring_sqe *)sqesMap;
+
+                cqHead = (unsigned *)(cq + params.cq_off.head);
+                cqTail = (unsigned *)(cq + params.cq_off.tail);
+                cqMask = *(unsigned *)(cq + params.cq_off.ring_mask);
+                cqes = (io_uring_cqe *)(cq + params.cq_off.cqes);
+
+                tail = *sqTail;
+            }
+
+            ~Ring() {
+                if (sqes != nullptr) {
+                    ::munmap(sqes, sqesSize);
+                }
+
+                release();
+            }
+
+            bool ok() const {
+                return fd >= 0;
+            }
+
+            /**
+             * Returns a cleared submission entry, which is queued once
+             * the caller fills it in, or nullptr if the queue is full
+             * */
+            io_uring_sqe *next() {
+                unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+
+                if (tail - head >= sqEntries) {
+                    return nullptr;
+                }
+
+                unsigned slot = tail & sqMask;
+                sqArray[slot] = slot;
+                io_uring_sqe *sqe = &sqes[slot];
+                std::memset(sqe, 0, sizeof(*sqe));
+
+                ++tail;
+                ++queued;
+
+                return sqe;
+            }
+
+            /**
+             * Hands the queued entries to the kernel and waits until at
+             * least `wait` completions are available
+             * */
+            void submit(unsigned wait) {
+                __atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+
+                while (true) {
+                    long result = ::syscall(
+                        __NR_io_uring_enter, fd, queued, wait,
+                        wait != 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+
+                    if (result >= 0) {
+                        queued -= (unsigned)result;
+
+                        if (queued == 0 || wait != 0) {
+                            return;
+                        }
+
+                        continue;
+                    }
+
+                    if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                        throw std::system_error(errno, std::generic_category(), "io_uring_enter");
+                    }
+                }
+            }
+
+            // calls handler(user data, result) for every available completion
+            template<typename Handler>
+            void reap(Handler &&handler) {
+                unsigned head = *cqHead;
+                unsigned end = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+
+                for (; head != end; ++head) {
+                    const io_uring_cqe &cqe = cqes[head & cqMask];
+                    handler(cqe.user_data, cqe.res);
+                }
+
+                __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+            }
+
+        private:
+            void release() {
+                if (cqRing != MAP_FAILED && cqRing != sqRing) {
+                    ::munmap(cqRing, cqRingSize);
+                }
+
+                if (sqRing != MAP_FAILED) {
+                    ::munmap(sqRing, sqRingSize);
+                }
+
+                if (fd >= 0) {
+                    ::close(fd);
+                }
+
+                sqRing = cqRing = MAP_FAILED;
+                fd = -1;
+            }
+
+        private:
+            int fd = -1;
+            void *sqRing = MAP_FAILED;
+            void *cqRing = MAP_FAILED;
+            std::size_t sqRingSize = 0;
+            std::size_t cqRingSize = 0;
+            std::size_t sqesSize = 0;
+
+            unsigned *sqHead = nullptr;
+            unsigned *sqTail = nullptr;
+            unsigned *sqArray = nullptr;
+            unsigned sqMask = 0;
+            unsigned sqEntries = 0;
+            io_uring_sqe *sqes = nullptr;
+
+            unsigned *cqHead = nullptr;
+            unsigned *cqTail = nullptr;
+            unsigned cqMask = 0;
+            io_uring_cqe *cqes = nullptr;
+
+            unsigned tail = 0;      // our copy of the submission tail
+            unsigned queued = 0;    // entries not yet taken by the kernel
+    };
+#endif
+};
+
+Ingest::Ingest(std::size_t depth, std::size_t consumers, bool useIoUring)
+    : depth(std::max<std::size_t>(depth, 1)), preferred(useIoUring ? IoUring : Pread), used(Pread)
+{
+    for (std::size_t i = 0; i < this->depth + consumers; ++i) {
+        buffers.push_back(std::make_unique<Buffer>());
+        free.push_back(buffers.back().get());
+    }
+}
+
+Ingest::~Ingest() = default;
+
+Ingest::Backend Ingest::backend() const {
+    return used;
+}
+
+Ingest::Buffer *Ingest::acquire() {
+    std::unique_lock<std::mutex> lock{ freeMutex };
+    released.wait(lock, [this] { return !free.empty(); });
+
+    Buffer *buffer = free.back();
+    free.pop_back();
+
+    return buffer;
+}
+
+Ingest::Buffer *Ingest::tryAcquire() {
+    std::lock_guard<std::mutex> lock{ freeMutex };
+
+    if (free.empty()) {
+        return nullptr;
+    }
+
+    Buffer *buffer = free.back();
+    free.pop_back();
+
+    return buffer;
+}
+
+void Ingest::recycle(Buffer *buffer) {
+    {
+        std::lock_guard<std::mutex> lock{ freeMutex };
+        free.push_back(buffer);
+    }
+
+    released.notify_one();
+}
+
+void Ingest::read(const std::vector<fs::path> &files, const std::vector<std::size_t> &order, const Ready &ready) {
+    if (preferred == IoUring && readWithUring(files, order, ready)) {
+        used = IoUring;
+        return;
+    }
+
+    used = Pread;
+    readWithPread(files, order, ready);
+}
+
+bool Ingest::readWithUring(const std::vector<fs::path> &files, const std::vector<std::size_t> &order, const Ready &ready) {
+#if defined(JSON_PARSER_IO_URING)
+    Ring ring{ (unsigned)depth };
+
+    if (!ring.ok()) {
+        return false;
+    }
+
+    // a read in flight, the kernel writes through `vector` until it completes
+    struct Pending {
+        Buffer *buffer;
+        int fd;
+        std::size_t done;
+        iovec vector;
+    };
+
+    std::vector<Pending> pending(depth);
+    std::vector<std::size_t> slots;
+
+    for (std::size_t i = depth; i > 0; --i) {
+        slots.push_back(i - 1);
+    }
+
+    auto queueRead = [&ring, &pending](std::size_t slot) {
+        Pending &read = pending[slot];
+        read.vector.iov_base = read.buffer->data.data() + read.done;
+        read.vector.iov_len = std::min(read.buffer->data.size() - read.done, MAX_READ);
+
+        // at most `depth` reads are in flight, so the queue always has room
+        io_uring_sqe *sqe = ring.next();
+        sqe->opcode = IORING_OP_READV;
+        sqe->fd = read.fd;
+        sqe->off = read.done;
+        sqe->addr = (unsigned long long)(std::uintptr_t)&read.vector;
+        sqe->len = 1;
+        sqe->user_data = slot;
+    };
+
+    auto complete = [&ready, &slots, &pending](std::size_t slot, bool ok) {
+        Pending &read = pending[slot];
+        ::close(read.fd);
+        read.buffer->ok = ok;
+        ready(read.buffer);
+        slots.push_back(slot);
+    };
+
+    std::size_t next = 0;
+    std::size_t inflight = 0;
+
+    while (next < order.size() || inflight > 0) {
+        // keep the queue full while there are buffers, but only block
+        // for one when nothing is in flight
+        while (inflight < depth && next < order.size()) {
+            Buffer *buffer = (inflight == 0) ? acquire() : tryAcquire();
+
+            if (buffer == nullptr) {
+                break;
+            }
+
+            std::size_t size = 0;
+            buffer->index = order[next++];
+            buffer->ok = false;
+            int fd = openFile(files[buffer->index], size);
+
+            if (fd < 0) {
+                buffer->data.clear();
+                ready(buffer);
+                continue;
+            }
+
+            buffer->data.resize(size);
+
+            if (size == 0) {
+                ::close(fd);
+                buffer->ok = true;
+                ready(buffer);
+                continue;
+            }
+
+            std::size_t slot = slots.back();
+            slots.pop_back();
+            pending[slot] = { buffer, fd, 0, {} };
+            queueRead(slot);
+            inflight++;
+        }
+
+        if (inflight == 0) {
+            continue;
+        }
+
+        ring.submit(1);
+        ring.reap([&](std::uint64_t slot, int result) {
+            Pending &read = pending[slot];
+
+            if (result == -EINTR || result == -EAGAIN) {
+                queueRead(slot);
+                return;
+            }
+
+            // a file that shrank while it was read fails like an error
+            if (result <= 0) {
+                complete(slot, false);
+                inflight--;
+                return;
+            }
+
+            read.done += (std::size_t)result;
+
+            if (read.done == read.buffer->data.size()) {
+                complete(slot, true);
+                inflight--;
+            } else {
+                queueRead(slot);
+            }
+        });
+    }
+
+    return true;
+#else
+    (void)files;
+    (void)order;
+    (void)ready;
+
+    return false;
+#endif
+}
+
+void Ingest::readWithPread(const std::vector<fs::path> &files, const std::vector<std::size_t> &order, const Ready &ready) {
+    std::atomic<std::size_t> next{ 0 };
+
+    auto work = [&]() {
+        while (true) {
+            Buffer *buffer = acquire();
+            std::size_t position = next++;
+
+            if (position >= order.size()) {
+                recycle(buffer);
+                return;
+            }
+
+            std::size_t size = 0;
+            buffer->index = order[position];
+            buffer->ok = false;
+            int fd = openFile(files[buffer->index], size);
+
+            if (fd < 0) {
+                buffer->data.clear();
+                ready(buffer);
+                continue;
+            }
+
+            buffer->data.resize(size);
+            std::size_t done = 0;
+
+            while (done < size) {
+                ssize_t result = ::pread(fd, buffer->data.data() + done, std::min(size - done, MAX_READ), (off_t)done);
+
+                if (result < 0 && errno == EINTR) {
+                    continue;
+                }
+
+                if (result <= 0) {
+                    break;
+                }
+
+                done += (std::size_t)result;
+            }
+
+            ::close(fd);
+            buffer->ok = (done == size);
+            ready(buffer);
+        }
+    };
+
+    std::size_t count = std::min({ depth, MAX_PREAD_THREADS, std::max<std::size_t>(order.size(), 1) });
+    std::vector<std::thread> threads;
+
+    for (std::size_t i = 1; i < count; ++i) {
+        threads.emplace_back(work);
+    }
+
+    // the calling thread reads too
+    work();
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * The I/O stage of the batch mode: reads files ahead of the parse
+ * workers so that disk and CPU work overlap.
+ *
+ * Reads are submitted through io_uring where the kernel supports it
+ * and through a few threads doing blocking pread() otherwise. At most
+ * `depth` reads are outstanding at once, and every file is read into a
+ * buffer taken from a fixed pool that the consumer hands back with
+ * recycle(), which bounds the memory held by files read but not yet
+ * parsed.
+ * */
+class Ingest {
+    public:
+        struct Buffer {
+            std::size_t index;  // of the file in the list given to read()
+            std::string data;
+            bool ok;
+        };
+
+        enum Backend {
+            IoUring,
+            Pread
+        };
+
+        using Ready = std::function<void(Buffer *buffer)>;
+
+        /**
+         * @param[in] depth
+         *     The maximum number of reads in flight.
+         *
+         * @param[in] consumers
+         *     The number of threads that may hold a buffer at the same
+         *     time, the pool has depth + consumers buffers.
+         *
+         * @param[in] useIoUring
+         *     false forces the pread() backend.
+         * */
+        Ingest(std::size_t depth, std::size_t consumers, bool useIoUring = true);
+        ~Ingest();
+
+        /**
+         * This method reads the files in the given order and passes each
+         * buffer to ready() as soon as it is complete, possibly from
+         * another thread. It returns once every file has been passed on.
+         * */
+        void read(
+            const std::vector<std::filesystem::path> &files,
+            const std::vector<std::size_t> &order,
+            const Ready &ready);
+
+        // this method returns a buffer to the pool once its content is consumed
+        void recycle(Buffer *buffer);
+
+        Backend backend() const;
+
+    private:
+        Buffer *acquire();
+        Buffer *tryAcquire();
+        bool readWithUring(
+            const std::vector<std::filesystem::path> &files,
+            const std::vector<std::size_t> &order,
+            const Ready &ready);
+        void readWithPread(
+            const std::vector<std::filesystem::path> &files,
+            const std::vector<std::size_t> &order,
+            const Ready &ready);
+
+    private:
+        std::size_t depth;
+        Backend preferred;
+        Backend used;
+
+        std::vector<std::unique_ptr<Buffer>> buffers;
+        std::vector<Buffer *> free;
+        std::mutex freeMutex;
+        std::condition_variable released;
+};
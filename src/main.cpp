@@ -1,39 +1,240 @@
+#include <charconv>
+#include <cstdlib>
 #include <iostream>
 #include <fstream>
+#include <memory>
+#include <utility>
 
+#include <decompress.hpp>
 #include <json.hpp>
+#include <offsets.hpp>
+
+#include "batch.hpp"
+#include "cache.hpp"
+
+namespace {
+
+    // default bound on the total size of the cache directory
+    constexpr std::uintmax_t DEFAULT_CACHE_SIZE = 256ULL * 1024 * 1024;
+
+    std::filesystem::path defaultCacheDirectory() {
+        if (const char *dir = std::getenv("JSON_PARSER_CACHE_DIR")) {
+            return dir;
+        }
+
+        if (const char *dir = std::getenv("XDG_CACHE_HOME")) {
+            return std::filesystem::path(dir) / "json-parser";
+        }
+
+        if (const char *dir = std::getenv("HOME")) {
+            return std::filesystem::path(dir) / ".cache" / "json-parser";
+        }
+
+        return {};
+    }
+
+    // a whole decimal number that fits in a std::size_t
+    bool parsePosition(const std::string &text, std::size_t &position) {
+        const char *end = text.data() + text.size();
+        auto [stop, error] = std::from_chars(text.data(), end, position);
+
+        return !text.empty() && error == std::errc() && stop == end;
+    }
+};
 
 int main(int argc, char *argv[])
 {
-    if (argc == 1) {
+    std::vector<std::filesystem::path> inputs;
+    std::string fileList;
+    Batch::Options batchOptions;
+    bool batch = false;
+    bool streamElements = false;
+    bool buildIndex = false;
+    std::string indexField;
+    // each lookup is by key when true, by position otherwise
+    std::vector<std::pair<bool, std::string>> lookups;
+    bool useCache = true;
+    std::filesystem::path cacheDirectory = defaultCacheDirectory();
+    std::uintmax_t cacheSize = DEFAULT_CACHE_SIZE;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg{ argv[i] };
+
+        // an option missing its value is never taken for an input
+        bool takesValue = arg == "--cache-dir" || arg == "--cache-size" || arg == "--index-field" ||
+            arg == "--element" || arg == "--key" || arg == "--file-list" || arg == "--jobs" || arg == "--read-ahead";
+
+        if (takesValue && i + 1 == argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return -1;
+        }
+
+        if (arg == "--no-cache") {
+            useCache = false;
+        } else if (arg == "--cache-dir") {
+            cacheDirectory = argv[++i];
+        } else if (arg == "--cache-size") {
+            cacheSize = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--elements") {
+            streamElements = true;
+        } else if (arg == "--index") {
+            buildIndex = true;
+        } else if (arg == "--index-field") {
+            indexField = argv[++i];
+            buildIndex = true;
+        } else if (arg == "--element" || arg == "--key") {
+            bool byKey = (arg == "--key");
+            lookups.emplace_back(byKey, argv[++i]);
+        } else if (arg == "--batch") {
+            batch = true;
+        } else if (arg == "--file-list") {
+            fileList = argv[++i];
+            batch = true;
+        } else if (arg == "--jobs") {
+            batchOptions.jobs = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--quiet") {
+            batchOptions.quiet = true;
+        } else if (arg == "--read-ahead") {
+            batchOptions.readAhead = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--no-io-uring") {
+            batchOptions.ioUring = false;
+        } else {
+            inputs.emplace_back(argv[i]);
+        }
+    }
+
+    std::error_code error;
+
+    if (inputs.size() > 1 || (inputs.size() == 1 && std::filesystem::is_directory(inputs[0], error))) {
+        batch = true;
+    }
+
+    if (batch) {
+        return Batch::run(inputs, fileList, batchOptions, std::cout);
+    }
+
+    if (inputs.empty()) {
         return -1;
     }
 
-    std::ifstream file{ argv[1] };
+    const std::filesystem::path &input = inputs[0];
+
+    // the sidecar index of a top-level Array, and lookups through it
+    // that parse only the elements asked for
+    std::filesystem::path sidecar = input;
+    sidecar += ".idx";
+
+    if (buildIndex && !JSON::OffsetIndex::buildFile(input, sidecar, indexField)) {
+        std::cerr << "Could not index " << input << std::endl;
+        return -5;
+    }
+
+    if (!lookups.empty()) {
+        JSON::IndexedFile indexed;
+
+        if (!indexed.open(input, sidecar)) {
+            std::cerr << "No index of " << input << ", build it with --index" << std::endl;
+            return -5;
+        }
+
+        for (const auto &[byKey, lookup] : lookups) {
+            std::size_t position = 0;
+            JSON::Json element = byKey ? indexed.find(lookup) :
+                parsePosition(lookup, position) ? indexed.element(position) : JSON::Json();
+
+            if (element.isInvalid()) {
+                std::cerr << "No element " << lookup << std::endl;
+                return -4;
+            }
+
+            std::cout << element << std::endl;
+        }
+
+        return 0;
+    }
+
+    if (buildIndex) {
+        return 0;
+    }
+
+    std::ifstream file{ input, std::ios::binary };
 
     if (!file.is_open()) {
         return -2;
     }     
 
+    // the elements of a top-level Array one at a time, decompressed on
+    // the way without holding the whole text
+    if (streamElements) {
+        JSON::ChunkReader reader = [&file](char *buffer, std::size_t capacity) {
+            file.read(buffer, (std::streamsize)capacity);
+            return (std::size_t)file.gcount();
+        };
+
+        std::size_t count = 0;
+
+        for (auto &element : JSON::elements(JSON::decompressing(std::move(reader)))) {
+            if (element.isInvalid()) {
+                std::cerr << "Invalid input after " << count << " elements" << std::endl;
+                return -4;
+            }
+
+            std::cout << element << std::endl;
+            ++count;
+        }
+
+        std::cout << "Elements: " << count << std::endl;
+
+        return 0;
+    }
+
     file.seekg(0, std::ios::end);
     long long fsize = (long long)file.tellg();
     
-    if (fsize == 0) {
+    if (fsize <= 0) {
         file.close();
         return -3;
     }
 
-    char buffer[fsize];
+    std::string data((std::size_t)fsize, '\0');
     file.seekg(0, std::ios::beg);
-    file.read(buffer, (std::streamsize)fsize);
+    file.read(data.data(), (std::streamsize)fsize);
     file.close();
-    std::string data{ buffer };
+
+    // .json.gz and .json.zst files are told apart by their magic bytes
+    if (JSON::detectCodec(data) != JSON::Codec::Plain) {
+        std::string text;
+
+        if (!JSON::decompress(data, text)) {
+            return -4;
+        }
+
+        data = std::move(text);
+    }
 
     if (data.empty()) {
         return -4;
     }
 
-    JSON::Json json = JSON::Json::fromCppString(data);
+    std::unique_ptr<DocumentCache> cache;
+    auto modified = std::filesystem::last_write_time(input, error);
+
+    if (useCache && !cacheDirectory.empty() && !error) {
+        cache = std::make_unique<DocumentCache>(cacheDirectory, cacheSize);
+    }
+
+    JSON::Json *parsed = cache ? cache->load(data, modified) : nullptr;
+
+    if (parsed == nullptr) {
+        parsed = JSON::Json::fromCppString(data);
+
+        if (cache && !parsed->isInvalid()) {
+            cache->store(data, modified, *parsed);
+        }
+    }
+
+    JSON::Json json = parsed;
+    delete parsed;
 
     std::cout << "Welcome to JSON Parser" << std::endl;
     std::cout << "C++ 2020" << std::endl;
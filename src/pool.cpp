@@ -0,0 +1,122 @@
+#include "pool.hpp"
+
+WorkStealingPool::WorkStealingPool(std::size_t workers)
+    : queued(0), pushed(0), stolen(0), closed(false)
+{
+    if (workers == 0) {
+        workers = 1;
+    }
+
+    for (std::size_t i = 0; i < workers; ++i) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    if (!threads.empty()) {
+        finish();
+    }
+}
+
+std::size_t WorkStealingPool::size() const {
+    return queues.size();
+}
+
+std::size_t WorkStealingPool::steals() const {
+    return stolen;
+}
+
+bool WorkStealingPool::take(std::size_t worker, std::size_t &index) {
+    for (std::size_t i = 0; i < queues.size(); ++i) {
+        Queue &queue = *queues[(worker + i) % queues.size()];
+        std::lock_guard<std::mutex> lock{ queue.mutex };
+
+        if (queue.tasks.empty()) {
+            continue;
+        }
+
+        // the owner takes the oldest task, thieves the newest
+        if (i == 0) {
+            index = queue.tasks.front();
+            queue.tasks.pop_front();
+        } else {
+            index = queue.tasks.back();
+            queue.tasks.pop_back();
+            ++stolen;
+        }
+
+        --queued;
+        return true;
+    }
+
+    return false;
+}
+
+void WorkStealingPool::work(std::size_t worker) {
+    std::size_t index;
+
+    while (true) {
+        if (take(worker, index)) {
+            task(index, worker);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock{ idleMutex };
+        idle.wait(lock, [this] { return queued > 0 || closed; });
+
+        if (queued == 0 && closed) {
+            return;
+        }
+    }
+}
+
+void WorkStealingPool::start(const Task &task) {
+    this->task = task;
+    queued = 0;
+    pushed = 0;
+    stolen = 0;
+    closed = false;
+
+    for (std::size_t worker = 0; worker < queues.size(); ++worker) {
+        threads.emplace_back(&WorkStealingPool::work, this, worker);
+    }
+}
+
+void WorkStealingPool::push(std::size_t index) {
+    Queue &queue = *queues[pushed++ % queues.size()];
+
+    {
+        std::lock_guard<std::mutex> lock{ queue.mutex };
+        queue.tasks.push_back(index);
+        ++queued;
+    }
+
+    // taking the lock orders this against a worker about to sleep
+    { std::lock_guard<std::mutex> lock{ idleMutex }; }
+    idle.notify_one();
+}
+
+void WorkStealingPool::finish() {
+    {
+        std::lock_guard<std::mutex> lock{ idleMutex };
+        closed = true;
+    }
+
+    idle.notify_all();
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    threads.clear();
+}
+
+void WorkStealingPool::run(const std::vector<std::size_t> &order, const Task &task) {
+    start(task);
+
+    for (auto index : order) {
+        push(index);
+    }
+
+    finish();
+}
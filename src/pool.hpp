@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A fixed set of worker threads with one task queue each.
+ *
+ * Tasks are indices handed out round-robin in the order they are
+ * pushed, so callers that push them by decreasing cost get the
+ * expensive ones started first. A worker takes tasks from the front of
+ * its own queue and, once that runs dry, steals from the back of the
+ * others, which keeps every core busy until the last task is taken.
+ * */
+class WorkStealingPool {
+    public:
+        using Task = std::function<void(std::size_t index, std::size_t worker)>;
+
+        explicit WorkStealingPool(std::size_t workers);
+        ~WorkStealingPool();
+
+        /**
+         * This method starts the workers, which then run task(index,
+         * worker) for every index pushed until finish() is called
+         *
+         * @param[in] task
+         *     The work to do, worker identifies the calling thread in
+         *     [0, size()) so it can keep per-thread state.
+         * */
+        void start(const Task &task);
+
+        // this method queues one task, it may be called from any thread
+        void push(std::size_t index);
+
+        // this method waits until every pushed task is done and stops the workers
+        void finish();
+
+        /**
+         * This method runs task(index, worker) for every index in order
+         * and returns once all of them are done
+         * */
+        void run(const std::vector<std::size_t> &order, const Task &task);
+
+        std::size_t size() const;
+
+        // the number of tasks taken from another worker's queue in the last run
+        std::size_t steals() const;
+
+    private:
+        struct Queue {
+            std::mutex mutex;
+            std::deque<std::size_t> tasks;
+        };
+
+        bool take(std::size_t worker, std::size_t &index);
+        void work(std::size_t worker);
+
+    private:
+        std::vector<std::unique_ptr<Queue>> queues;
+        std::vector<std::thread> threads;
+        Task task;
+
+        std::atomic<std::size_t> queued;
+        std::atomic<std::size_t> pushed;
+        std::atomic<std::size_t> stolen;
+
+        std::mutex idleMutex;
+        std::condition_variable idle;
+        bool closed;
+};
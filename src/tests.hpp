@@ -1,6 +1,24 @@
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include <unistd.h>
+
+#include <aggregate.hpp>
+#include <columns.hpp>
+#include <decompress.hpp>
 #include <json.hpp>
+#include <offsets.hpp>
+#include <parser.hpp>
+#include <serialize.hpp>
+#include <writer.hpp>
+
+#include "allocations.hpp"
+#include "cache.hpp"
 
 namespace JSON {
     
@@ -141,4 +159,1308 @@ namespace JSON {
         ASSERT_TRUE(jsonLargeObject.isObject());
         ASSERT_EQ(jsonLargeObject["numbers"][1]["name"], "ebrahim");
     }
-};
\ No newline at end of file
+
+    TEST(JSONTestSuite, testBinaryRoundTrip) {
+        const auto json = Json::fromCppString("{\"name\": \"ebrahim\", \"age\": -27, \"salary\": null, \"ratio\": 2.5, \"numbers\": [1, true, [false]]}");
+        const std::string binary = json->toBinary();
+        const auto decoded = Json::fromBinary(binary.data(), binary.size());
+        const auto truncated = Json::fromBinary(binary.data(), binary.size() - 1);
+
+        ASSERT_TRUE(decoded->isObject());
+        ASSERT_EQ((*decoded)["name"], "ebrahim");
+        ASSERT_EQ((*decoded)["age"], -27);
+        ASSERT_TRUE((*decoded)["salary"].isNull());
+        ASSERT_DOUBLE_EQ((*decoded)["ratio"], 2.5);
+        ASSERT_EQ((*decoded)["numbers"][1], true);
+        ASSERT_EQ((*decoded)["numbers"][2][0], false);
+        ASSERT_EQ(decoded->toBinary().size(), binary.size());
+
+        ASSERT_TRUE(truncated->isInvalid());
+    }
+
+    TEST(JSONTestSuite, testCopyOnWrite) {
+        Json original = Json::fromCppString("{\"name\": \"ebrahim\", \"numbers\": [1, [2, 3]], \"siblings\": [\"norhan\"]}");
+        Json snapshot = original;
+        Json four;
+        four = 4;
+
+        original.at("numbers").at(1).at(0) = 20;
+        original.at("numbers").append(four);
+        original.at("name") = "mahmoud";
+
+        ASSERT_EQ(original["numbers"][1][0], 20);
+        ASSERT_EQ(original["numbers"][2], 4);
+        ASSERT_EQ(original["name"], "mahmoud");
+
+        ASSERT_EQ(snapshot["numbers"][1][0], 2);
+        ASSERT_EQ(snapshot["numbers"].size(), 2);
+        ASSERT_EQ(snapshot["name"], "ebrahim");
+
+        // untouched subtrees are still shared by both copies
+        ASSERT_TRUE(original["siblings"] == snapshot["siblings"]);
+        ASSERT_FALSE(original["numbers"] == snapshot["numbers"]);
+    }
+
+    TEST(JSONTestSuite, testReparse) {
+        std::string text = "{\"name\": \"ebrahim\", \"age\": 27, \"numbers\": [1, 2, 3], \"parents\": [{\"name\": \"ahmad\"}]}";
+        const auto document = Json::fromCppString(text);
+        const Json *firstNumber = &document->at("numbers").at(0);
+
+        ASSERT_TRUE(Json::reparse(*document, text, {
+            { text.find("27"), 2, "28" },
+            { text.find("2,"), 1, "[5, 6]" },
+            { text.find("\"ahmad\""), 7, "\"tahany\"" }
+        }));
+
+        ASSERT_EQ(text, "{\"name\": \"ebrahim\", \"age\": 28, \"numbers\": [1, [5, 6], 3], \"parents\": [{\"name\": \"tahany\"}]}");
+        ASSERT_EQ((*document)["age"], 28);
+        ASSERT_EQ((*document)["numbers"][1][1], 6);
+        ASSERT_EQ((*document)["parents"][0]["name"], "tahany");
+        ASSERT_EQ((*document)["name"], "ebrahim");
+
+        // untouched nodes stay where they were
+        ASSERT_EQ(firstNumber, &document->at("numbers").at(0));
+        ASSERT_EQ(*firstNumber, 1);
+
+        // an edit that breaks the text changes nothing
+        const std::string before = text;
+        ASSERT_FALSE(Json::reparse(*document, text, { { text.find("[5"), 1, "" } }));
+        ASSERT_EQ(text, before);
+        ASSERT_EQ((*document)["numbers"][1][0], 5);
+    }
+
+    TEST(JSONTestSuite, testPatch) {
+        const auto document = Json::fromCppString("{\"name\": \"ebrahim\", \"age\": 27, \"numbers\": [1, 2, 3], \"parents\": [{\"name\": \"ahmad\"}]}");
+        const auto patch = Json::fromCppString("[{\"op\": \"replace\", \"path\": \"/age\", \"value\": 28}, {\"op\": \"add\", \"path\": \"/numbers/-\", \"value\": 4}, {\"op\": \"remove\", \"path\": \"/numbers/0\"}, {\"op\": \"add\", \"path\": \"/parents/0/age\", \"value\": 64}, {\"op\": \"copy\", \"from\": \"/parents/0\", \"path\": \"/father\"}, {\"op\": \"move\", \"from\": \"/name\", \"path\": \"/first_name\"}, {\"op\": \"test\", \"path\": \"/father/age\", \"value\": 64}]");
+        const auto failing = Json::fromCppString("[{\"op\": \"remove\", \"path\": \"/age\"}, {\"op\": \"test\", \"path\": \"/numbers/0\", \"value\": 1}]");
+        Json inverse;
+
+        ASSERT_TRUE(document->applyPatch(*patch, &inverse));
+        ASSERT_EQ((*document)["age"], 28);
+        ASSERT_EQ((*document)["numbers"].size(), 3);
+        ASSERT_EQ((*document)["numbers"][0], 2);
+        ASSERT_EQ((*document)["numbers"][2], 4);
+        ASSERT_EQ((*document)["father"]["age"], 64);
+        ASSERT_EQ((*document)["first_name"], "ebrahim");
+        ASSERT_THROW((*document)["name"], std::out_of_range);
+
+        // a failed patch leaves the document as it was
+        ASSERT_FALSE(document->applyPatch(*failing));
+        ASSERT_EQ((*document)["age"], 28);
+
+        ASSERT_TRUE(document->applyPatch(inverse));
+        ASSERT_EQ((*document)["age"], 27);
+        ASSERT_EQ((*document)["name"], "ebrahim");
+        ASSERT_EQ((*document)["numbers"][0], 1);
+        ASSERT_EQ((*document)["numbers"].size(), 3);
+        ASSERT_EQ((*document)["parents"][0].size(), 1);
+        ASSERT_EQ(document->size(), 4);
+    }
+
+    TEST(JSONTestSuite, testMergePatch) {
+        const auto document = Json::fromCppString("{\"name\": \"ebrahim\", \"age\": 27, \"job\": {\"title\": \"student\", \"salary\": 0}}");
+        const auto patch = Json::fromCppString("{\"age\": null, \"job\": {\"title\": \"engineer\", \"salary\": null}, \"siblings\": [\"norhan\"]}");
+        Json inverse;
+
+        document->applyMergePatch(*patch, &inverse);
+        ASSERT_THROW((*document)["age"], std::out_of_range);
+        ASSERT_EQ((*document)["job"]["title"], "engineer");
+        ASSERT_EQ((*document)["job"].size(), 1);
+        ASSERT_EQ((*document)["siblings"][0], "norhan");
+
+        ASSERT_TRUE(document->applyPatch(inverse));
+        ASSERT_EQ((*document)["age"], 27);
+        ASSERT_EQ((*document)["job"]["title"], "student");
+        ASSERT_EQ((*document)["job"]["salary"], 0);
+        ASSERT_EQ(document->size(), 3);
+    }
+
+    TEST(JSONTestSuite, testHashAndDiff) {
+        ParseOptions options;
+        options.computeHashes = true;
+
+        const auto before = Json::fromCppString("{\"name\": \"ebrahim\", \"age\": 27, \"numbers\": [1, 2, 3], \"parents\": [{\"name\": \"ahmad\"}]}", options);
+        const auto same = Json::fromCppString("{\"parents\": [{\"name\": \"ahmad\"}], \"numbers\": [1, 2, 3], \"age\": 27, \"name\": \"ebrahim\"}");
+        Json after = *before;
+
+        // equality compares content, not identity
+        ASSERT_TRUE(*before == *same);
+        ASSERT_EQ(before->hash(), same->hash());
+
+        after.at("numbers").at(1) = 20;
+        after.at("numbers").append(after["age"]);
+        after.erase("name");
+        after.insert("job", *Json::parseString("\"student\""));
+
+        ASSERT_FALSE(*before == after);
+        ASSERT_NE(before->hash(), after.hash());
+        ASSERT_TRUE((*before)["parents"] == after["parents"]);
+
+        Json patch = Json::diff(*before, after);
+        ASSERT_EQ(patch.size(), 4);
+
+        Json patched = *before;
+        ASSERT_TRUE(patched.applyPatch(patch));
+        ASSERT_TRUE(patched == after);
+
+        ASSERT_EQ(Json::diff(after, patched).size(), 0);
+
+        // confirming equal hashes finds the same changes
+        ASSERT_TRUE(Json::diff(*before, after, true) == patch);
+        ASSERT_EQ(Json::diff(after, patched, true).size(), 0);
+    }
+
+    TEST(JSONTestSuite, testDeduplicate) {
+        ParseOptions options;
+        options.deduplicate = true;
+
+        const std::string text = "[{\"status\": \"ok\", \"codes\": [1, 2]}, {\"status\": \"ok\", \"codes\": [1, 2]}, {\"status\": \"failed\", \"codes\": [1, 2]}]";
+        const auto json = Json::fromCppString(text, options);
+
+        ASSERT_TRUE((*json)[0] == (*json)[1]);
+        ASSERT_TRUE((*json)[0]["codes"] == (*json)[2]["codes"]);
+        ASSERT_EQ((*json)[2]["status"], "failed");
+
+        // equal subtrees are one node, counted once where they are reached again
+        Json *separate = Json::fromCppString(text);
+        MemoryUsage deduplicated = json->memoryUsage();
+
+        ASSERT_GT(deduplicated.shared, 0u);
+        ASSERT_EQ(separate->memoryUsage().shared, 0u);
+        ASSERT_LT(deduplicated.total(), separate->memoryUsage().total());
+        delete separate;
+
+        // modifying a shared node leaves its other uses alone
+        json->at(0).at("codes").at(0) = 5;
+
+        ASSERT_EQ((*json)[0]["codes"][0], 5);
+        ASSERT_EQ((*json)[1]["codes"][0], 1);
+        ASSERT_EQ((*json)[2]["codes"][0], 1);
+    }
+
+    TEST(JSONTestSuite, testValidate) {
+        auto check = [](const std::string &text) {
+            return validate(text.data(), text.size());
+        };
+
+        ASSERT_TRUE(check("{\"name\": \"ebrahim\", \"age\": 27, \"numbers\": [1, -2.5e+3, 0], \"ok\": [true, false, null, {}]}"));
+        ASSERT_TRUE(check(" \"caf\u00e9 \\u00e9 \\ud83d\\ude00 \\n\" "));
+        ASSERT_TRUE(check("42"));
+
+        ASSERT_EQ(check("[1, 2,]").errorOffset, 6);
+        ASSERT_EQ(check("[1 2]").errorOffset, 3);
+        ASSERT_EQ(check("{\"a\" 1}").errorOffset, 5);
+        ASSERT_EQ(check("[01]").errorOffset, 2);
+        ASSERT_EQ(check("[1.]").errorOffset, 3);
+        ASSERT_EQ(check("[tru]").errorOffset, 4);
+        ASSERT_EQ(check("[\"a\\x\"]").errorOffset, 3);
+        ASSERT_EQ(check("[\"\\ud83d\"]").errorOffset, 2);
+        ASSERT_EQ(check("[\"a\tb\"]").errorOffset, 3);
+        ASSERT_EQ(check("[\"\xC0\xAF\"]").errorOffset, 2);
+        ASSERT_EQ(check("[1]]").errorOffset, 3);
+        ASSERT_EQ(check("{\"a\": [1}").errorOffset, 8);
+        ASSERT_EQ(check("[[1]").errorOffset, 4);
+        ASSERT_EQ(check("").errorOffset, 0);
+
+        ASSERT_TRUE(check(std::string(MAX_VALIDATION_DEPTH, '[') + std::string(MAX_VALIDATION_DEPTH, ']')));
+        ASSERT_EQ(check(std::string(MAX_VALIDATION_DEPTH + 1, '[')).errorOffset, MAX_VALIDATION_DEPTH);
+    }
+
+    TEST(JSONTestSuite, testParseEscapedString) {
+        const auto escapes = Json::parseString("\"say \\\"hi\\\" \\\\ \\n caf\\u00e9 \\ud83d\\ude00\"");
+        const auto longString = Json::parseString("\"a string longer than sixteen bytes, caf\xC3\xA9 and \\t tab\"");
+        const auto badUtf8 = Json::parseString("\"abc\xC0\xAF\"");
+        const auto badEscape = Json::parseString("\"\\x\"");
+
+        ASSERT_TRUE(escapes->isString());
+        ASSERT_EQ(*escapes, "say \"hi\" \\ \n caf\xC3\xA9 \xF0\x9F\x98\x80");
+
+        ASSERT_TRUE(longString->isString());
+        ASSERT_EQ(*longString, "a string longer than sixteen bytes, caf\xC3\xA9 and \t tab");
+
+        ASSERT_TRUE(badUtf8->isInvalid());
+        ASSERT_TRUE(badEscape->isInvalid());
+
+        const auto document = Json::fromCppString("{\"k\\\"ey\": [\"a\\\"]\", {\"b\": \"}\"}], \"next\": 1}");
+
+        ASSERT_TRUE(document->isObject());
+        ASSERT_EQ(document->at("k\"ey").size(), 2);
+        ASSERT_EQ(document->at("k\"ey").at(0), "a\"]");
+        ASSERT_EQ(document->at("k\"ey").at(1).at("b"), "}");
+        ASSERT_EQ(document->at("next"), 1);
+    }
+
+    TEST(JSONTestSuite, testElements) {
+        std::string text = " [1, \"two, ]\", [3, [4]], {\"five\": 5}, null ] ";
+        std::vector<Json> all;
+
+        for (auto &element : elements(text)) {
+            all.push_back(element);
+        }
+
+        ASSERT_EQ(all.size(), 5);
+        ASSERT_EQ(all[0], 1);
+        ASSERT_EQ(all[1], "two, ]");
+        ASSERT_EQ(all[2].at(1).at(0), 4);
+        ASSERT_EQ(all[3].at("five"), 5);
+        ASSERT_TRUE(all[4].isNull());
+
+        // chunks of 3 bytes split numbers, strings and containers
+        std::size_t offset = 0;
+        std::size_t count = 0;
+        auto reader = [&text, &offset](char *buffer, std::size_t capacity) {
+            std::size_t size = std::min<std::size_t>({ capacity, 3, text.size() - offset });
+            text.copy(buffer, size, offset);
+            offset += size;
+            return size;
+        };
+
+        for (auto &element : elements(reader, 3)) {
+            ASSERT_EQ(element, all[count++]);
+        }
+
+        ASSERT_EQ(count, 5);
+
+        // the loop can stop before the rest is read
+        offset = 0;
+
+        for (auto &element : elements(reader, 3)) {
+            ASSERT_EQ(element, 1);
+            break;
+        }
+
+        ASSERT_LT(offset, text.size());
+
+        std::vector<bool> invalid;
+
+        for (auto &element : elements("[1, 2,]")) {
+            invalid.push_back(element.isInvalid());
+        }
+
+        ASSERT_EQ(invalid, std::vector<bool>({ false, false, true }));
+
+        count = 0;
+
+        // an empty Array yields nothing, not even an Invalid element
+        for (auto &element : elements("[]")) {
+            ADD_FAILURE() << "unexpected element " << element;
+            count++;
+        }
+
+        ASSERT_EQ(count, 0);
+
+        for (auto &element : elements("{\"a\": 1}")) {
+            ASSERT_TRUE(element.isInvalid());
+        }
+    }
+
+    TEST(JSONTestSuite, testIterativeParser) {
+        const auto numbers = Json::fromCppString(" [345.23e5, 0.1, -0, 9223372036854775807, 9223372036854775808, 1E-2] ");
+
+        ASSERT_TRUE(numbers->isArray());
+        ASSERT_DOUBLE_EQ(numbers->at(0), 34523000.0);
+        ASSERT_TRUE(numbers->at(1) == 0.1L);
+        ASSERT_TRUE(numbers->at(2).isInteger());
+        ASSERT_EQ(numbers->at(3), 9223372036854775807LL);
+        ASSERT_EQ(numbers->at(4), 9223372036854775808ULL);
+        ASSERT_DOUBLE_EQ(numbers->at(5), 0.01);
+
+        ASSERT_EQ(*Json::fromCppString("\"caf\\u00e9\""), "caf\xC3\xA9");
+        ASSERT_TRUE(Json::fromCppString("true")->isBoolean());
+        ASSERT_TRUE(Json::fromCppString("{\"a\": [1, 2,]}")->isInvalid());
+        ASSERT_TRUE(Json::fromCppString("{\"a\" 1}")->isInvalid());
+        ASSERT_TRUE(Json::fromCppString("[1] 2")->isInvalid());
+        ASSERT_TRUE(Json::fromCppString("")->isInvalid());
+
+        // the depth limit stops adversarial nesting before it costs anything
+        std::string deep = std::string(2000, '[') + std::string(2000, ']');
+        ASSERT_TRUE(Json::fromCppString(deep)->isInvalid());
+
+        ParseOptions options;
+        options.maxDepth = 100001;
+        deep = std::string(100000, '[') + "{\"a\": 1}" + std::string(100000, ']');
+
+        Json *json = Json::fromCppString(deep, options);
+        ASSERT_TRUE(json->isArray());
+
+        // a deep value is destroyed without deep recursion
+        delete json;
+    }
+
+    TEST(JSONTestSuite, testMemoryResource) {
+        // counts what a document takes from its resource
+        class CountingResource : public std::pmr::memory_resource {
+            public:
+                std::size_t allocations = 0;
+
+            private:
+                void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+                    allocations++;
+                    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+                }
+
+                void do_deallocate(void *pointer, std::size_t bytes, std::size_t alignment) override {
+                    std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+                }
+
+                bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+                    return this == &other;
+                }
+        };
+
+        CountingResource counting;
+        ParseOptions options;
+        options.resource = &counting;
+
+        Json *json = Json::fromCppString("{\"a long enough name to leave SSO\": [1, \"two\", {\"three\": 3}]}", options);
+        ASSERT_TRUE(json->isObject());
+        ASSERT_GE(counting.allocations, 4u);
+
+        // lookups take any string type
+        const std::string name = "a long enough name to leave SSO";
+        ASSERT_EQ(json->at(name).at(2)["three"], 3LL);
+        ASSERT_EQ((*json)[name.c_str()].size(), 3u);
+
+        // a copy that is mutated is cloned into the same resource
+        std::size_t before = counting.allocations;
+        Json copy = *json;
+        Json member;
+        member = true;
+        copy.insert("b", member);
+
+        ASSERT_GT(counting.allocations, before);
+        ASSERT_THROW(json->at("b"), std::out_of_range);
+        delete json;
+
+        // a bounded arena with no upstream holds the whole document
+        alignas(std::max_align_t) char buffer[16 * 1024];
+        std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+        options.resource = &arena;
+
+        json = Json::fromCppString("[\"x\", [true, null], {\"k\": 1.5}]", options);
+        ASSERT_TRUE(json->isArray());
+        ASSERT_DOUBLE_EQ(json->at(2)["k"], 1.5);
+        delete json;
+    }
+
+    TEST(JSONTestSuite, testAllocationBudgets) {
+        // a 10 KB document of small records, like a typical API response
+        std::string document = "{\"items\": [";
+
+        for (int i = 0; i < 100; ++i) {
+            document += (i == 0 ? "" : ", ");
+            document += "{\"id\": " + std::to_string(i) + ", \"name\": \"item number " + std::to_string(i) + "\", ";
+            document += "\"price\": " + std::to_string(i) + ".25, \"tags\": [\"a\", \"b\"], \"active\": true, \"note\": null}";
+        }
+
+        document += "], \"count\": 100}";
+        ASSERT_GE(document.size(), 10000u);
+
+        // every budget is a count of allocations and a number of bytes,
+        // lower it along with a change that allocates less. The counts are
+        // exact, the bytes are rounded up by about 10% since node and
+        // container sizes differ between standard libraries
+        auto expectBudget = [](const char *api, Allocations::Usage usage, std::size_t allocations, std::size_t bytes) {
+            EXPECT_LE(usage.allocations, allocations) << api;
+            EXPECT_LE(usage.bytes, bytes) << api;
+        };
+
+        Json *json = nullptr;
+        expectBudget("fromCppString", Allocations::measure([&]() { json = Json::fromCppString(document); }), 1320, 153000);
+        ASSERT_TRUE(json->isObject());
+
+        Json *value = nullptr;
+        std::string items = document.substr(10, document.rfind(']') - 9);
+        expectBudget("parseArray", Allocations::measure([&]() { value = Json::parseArray(items); }), 3184, 327000);
+        ASSERT_TRUE(value->isArray());
+        delete value;
+
+        std::string record = "{\"id\": 1, \"name\": \"item number 1\", \"price\": 1.25, \"tags\": [\"a\", \"b\"], \"active\": true, \"note\": null}";
+        expectBudget("parseObject", Allocations::measure([&]() { value = Json::parseObject(record); }), 28, 2950);
+        ASSERT_TRUE(value->isObject());
+        delete value;
+
+        std::string string = "\"a string long enough to live on the heap\"";
+        expectBudget("parseString", Allocations::measure([&]() { value = Json::parseString(string); }), 4, 220);
+        delete value;
+
+        std::string integer = "1234567890";
+        expectBudget("parseInteger", Allocations::measure([&]() { value = Json::parseInteger(integer); }), 1, 64);
+        delete value;
+
+        std::string floatingPoint = "-1234.5678e-3";
+        expectBudget("parseFloatingPoint", Allocations::measure([&]() { value = Json::parseFloatingPoint(floatingPoint); }), 1, 64);
+        delete value;
+
+        std::string boolean = "true";
+        expectBudget("parseBoolean", Allocations::measure([&]() { value = Json::parseBoolean(boolean); }), 1, 64);
+        delete value;
+
+        std::string null = "null";
+        expectBudget("parseNull", Allocations::measure([&]() { value = Json::parseNull(null); }), 1, 64);
+        delete value;
+
+        // reading through a const document never allocates
+        const Json &constant = *json;
+        const std::string key = "items";
+        std::size_t found = 0;
+
+        expectBudget("lookup", Allocations::measure([&]() {
+            const Json &records = constant.at(key);
+
+            for (int i = 0; i < 100; ++i) {
+                found += (records.at(i).at("id") == (long long)i && records[i]["name"].isString());
+            }
+        }), 0, 0);
+        ASSERT_EQ(found, 100u);
+
+        // a stream that discards everything leaves only the serializer's own allocations
+        class NullBuffer : public std::streambuf {
+            protected:
+                int overflow(int c) override { return c; }
+                std::streamsize xsputn(const char *, std::streamsize count) override { return count; }
+        };
+
+        NullBuffer buffer;
+        std::ostream sink(&buffer);
+
+        expectBudget("operator<<", Allocations::measure([&]() { sink << *json; }), 0, 0);
+
+        std::string binary;
+        expectBudget("toBinary", Allocations::measure([&]() { binary = json->toBinary(); }), 9, 17000);
+
+        expectBudget("fromBinary", Allocations::measure([&]() { value = Json::fromBinary(binary.data(), binary.size()); }), 1307, 130000);
+        ASSERT_TRUE(*value == *json);
+        delete value;
+
+        expectBudget("delete", Allocations::measure([&]() { delete json; }), 0, 0);
+    }
+
+    TEST(JSONTestSuite, testLazyNumbers) {
+        const std::string pi = "3.14159265358979323846264338327950288";
+        const std::string big = "-123456789012345678901234567890";
+        Json *json = Json::fromCppString("[18446744073709551615, 9223372036854775808, " + big + ", 0.1, 1e400, -0, " + pi + "]");
+
+        ASSERT_TRUE(json->isArray());
+        ASSERT_EQ(json->at(0).getNumber().getClass(), Number::Class::UInt64);
+        ASSERT_EQ(json->at(1).getNumber().getClass(), Number::Class::UInt64);
+        ASSERT_EQ(json->at(2).getNumber().getClass(), Number::Class::Big);
+        ASSERT_EQ(json->at(3).getNumber().getClass(), Number::Class::Double);
+        ASSERT_EQ(json->at(5).getNumber().getClass(), Number::Class::Int64);
+        ASSERT_TRUE(json->at(2).isInteger());
+        ASSERT_TRUE(json->at(6).isFloatingPoint());
+
+        // nothing wraps, values that do not fit throw
+        ASSERT_EQ((unsigned long long)json->at(0), 18446744073709551615ULL);
+        ASSERT_THROW((long long)json->at(1), std::out_of_range);
+        ASSERT_THROW((unsigned long long)json->at(2), std::out_of_range);
+        ASSERT_DOUBLE_EQ((double)json->at(2), -1.2345678901234568e29);
+        ASSERT_DOUBLE_EQ(json->at(3), 0.1);
+        ASSERT_TRUE(std::isinf((double)json->at(4)));
+        ASSERT_EQ(json->at(5), 0);
+
+        // the digits are written back verbatim
+        std::ostringstream output;
+        output << json->at(2) << ' ' << json->at(6) << ' ' << json->at(4);
+        ASSERT_EQ(output.str(), big + " " + pi + " 1e400");
+
+        std::string binary = json->toBinary();
+        Json *decoded = Json::fromBinary(binary.data(), binary.size());
+        ASSERT_TRUE(*decoded == *json);
+        ASSERT_EQ(decoded->hash(), json->hash());
+        ASSERT_EQ(decoded->at(2).getNumber().text(), big);
+        ASSERT_EQ(decoded->at(6).getNumber().text(), pi);
+
+        delete decoded;
+        delete json;
+
+        json = Json::parseInteger("18446744073709551615");
+        ASSERT_EQ(*json, 18446744073709551615ULL);
+        delete json;
+
+        // numbers from C++ have no digits
+        Json number;
+        number = 42ULL;
+        ASSERT_EQ(number.getNumber().getClass(), Number::Class::Int64);
+        ASSERT_TRUE(number.getNumber().text().empty());
+        ASSERT_EQ(number, 42);
+    }
+
+    TEST(JSONTestSuite, testPackedArrays) {
+        const std::string text = "{\"samples\": [1, 2, 3, -4], \"prices\": [0.5, 1.25, 300.0, -0.0], \"mixed\": [1, 2.5], "
+            "\"wide\": [1, 18446744073709551615], \"precise\": [0.12345678901234567]}";
+
+        Json *json = Json::fromCppString(text);
+        const Json &samples = json->at("samples");
+        const Json &prices = json->at("prices");
+
+        ASSERT_TRUE(samples.isPacked());
+        ASSERT_EQ(std::vector<std::int64_t>(samples.integers().begin(), samples.integers().end()), std::vector<std::int64_t>({ 1, 2, 3, -4 }));
+        ASSERT_THROW(samples.doubles(), WrongTypeException);
+        ASSERT_TRUE(prices.isPacked());
+        ASSERT_EQ(std::vector<double>(prices.doubles().begin(), prices.doubles().end()), std::vector<double>({ 0.5, 1.25, 300.0, -0.0 }));
+
+        // only arrays that keep every number and its spelling are packed
+        ASSERT_FALSE(json->at("mixed").isPacked());
+        ASSERT_FALSE(json->at("wide").isPacked());
+        ASSERT_FALSE(json->at("precise").isPacked());
+
+        // packed elements still read as Json values
+        ASSERT_EQ(samples.size(), 4u);
+        ASSERT_EQ(samples[3], -4);
+        ASSERT_EQ(samples.at(1), 2);
+        ASSERT_TRUE(prices.at(2).isFloatingPoint());
+
+        std::ostringstream output;
+        output << prices;
+        ASSERT_EQ(output.str(), "[ 0.5, 1.25, 300.0, -0.0, ]");
+
+        // packing does not change the content
+        ParseOptions options;
+        options.packNumbers = false;
+        Json *unpacked = Json::fromCppString(text, options);
+
+        ASSERT_FALSE(unpacked->at("samples").isPacked());
+        ASSERT_EQ(unpacked->hash(), json->hash());
+        ASSERT_TRUE(*unpacked == *json);
+        ASSERT_TRUE(*json == *unpacked);
+
+        std::string binary = json->toBinary();
+        Json *decoded = Json::fromBinary(binary.data(), binary.size());
+        ASSERT_TRUE(decoded->at("prices").isPacked());
+        ASSERT_TRUE(*decoded == *json);
+
+        // a modified copy is unpacked, the original keeps its numbers
+        Json copy = samples;
+        Json five;
+        five = 5;
+        copy.append(five);
+
+        ASSERT_FALSE(copy.isPacked());
+        ASSERT_EQ(copy.size(), 5u);
+        ASSERT_EQ(samples.integers().size(), 4u);
+
+        json->deduplicate();
+        ASSERT_TRUE(json->at("samples").isPacked());
+
+        // numbers are written as they were spelled, packed or not
+        for (const std::string array : { "[1.5e1, 2.0]", "[-0, 1]", "[1e-7, 2.0]", "[2.50, 1.0]", "[1E2, 3.0]", "[-0.0, 0.1, 1e+300]", "[15, -3]", "[1.5, 2.25]" }) {
+            Json *packed = Json::fromCppString(array);
+            Json *plain = Json::fromCppString(array, options);
+            std::ostringstream packedOutput;
+            std::ostringstream plainOutput;
+
+            packedOutput << *packed;
+            plainOutput << *plain;
+            ASSERT_EQ(packedOutput.str(), plainOutput.str()) << array;
+
+            delete plain;
+            delete packed;
+        }
+
+        Json *canonical = Json::fromCppString("[1.5, 2.25, -0.0]");
+        ASSERT_TRUE(canonical->isPacked());
+        delete canonical;
+
+        delete decoded;
+        delete unpacked;
+        delete json;
+    }
+
+    TEST(JSONTestSuite, testColumnarTable) {
+        const std::string text = "[{\"id\": 1, \"price\": 2, \"tag\": \"a\", \"ok\": true}, "
+            "{\"id\": 2, \"price\": 2.5, \"tag\": \"b\", \"extra\": [1, 2]}, "
+            "{\"id\": 3, \"price\": null, \"tag\": \"a\", \"ok\": \"yes\", \"id\": 4}]";
+
+        Table table;
+        ASSERT_TRUE(Table::fromText(text, table));
+        ASSERT_EQ(table.rows(), 3u);
+        ASSERT_EQ(table.names(), std::vector<std::string>({ "id", "price", "tag", "ok", "extra" }));
+
+        // the last of duplicate names wins
+        const Column &ids = table.column("id");
+        ASSERT_EQ(ids.getKind(), Column::Kind::Integer);
+        ASSERT_EQ(std::vector<std::int64_t>(ids.integers().begin(), ids.integers().end()), std::vector<std::int64_t>({ 1, 2, 4 }));
+        ASSERT_THROW(ids.doubles(), WrongTypeException);
+
+        // integers meeting decimals are widened, nulls clear the validity bit
+        const Column &prices = table.column("price");
+        ASSERT_EQ(prices.getKind(), Column::Kind::FloatingPoint);
+        ASSERT_EQ(prices.doubles()[0], 2.0);
+        ASSERT_EQ(prices.doubles()[1], 2.5);
+        ASSERT_TRUE(prices.isNull(2));
+        ASSERT_EQ(prices.validityBitmap()[0], 3u);
+
+        const Column &tags = table.column("tag");
+        ASSERT_EQ(tags.getKind(), Column::Kind::String);
+        ASSERT_EQ(tags.dictionary(), std::vector<std::string>({ "a", "b" }));
+        ASSERT_EQ(std::vector<std::uint32_t>(tags.codes().begin(), tags.codes().end()), std::vector<std::uint32_t>({ 0, 1, 0 }));
+
+        // kinds that do not mix fall back to Json values
+        const Column &ok = table.column("ok");
+        ASSERT_EQ(ok.getKind(), Column::Kind::Value);
+        ASSERT_EQ(ok.values()[0], true);
+        ASSERT_TRUE(ok.isNull(1));
+        ASSERT_EQ(ok.at(2), "yes");
+
+        const Column &extra = table.column("extra");
+        ASSERT_TRUE(extra.isNull(0));
+        ASSERT_EQ(extra.at(1).size(), 2u);
+        ASSERT_TRUE(extra.at(2).isNull());
+        ASSERT_FALSE(table.contains("missing"));
+        ASSERT_THROW(table.column("missing"), std::out_of_range);
+
+        // a parsed document gives the same table
+        Json *json = Json::fromCppString(text);
+        Table parsed = Table::fromJson(*json);
+
+        ASSERT_EQ(parsed.rows(), 3u);
+        ASSERT_EQ(parsed.column("price").getKind(), Column::Kind::FloatingPoint);
+        ASSERT_EQ(parsed.column("tag").dictionary().size(), 2u);
+
+        for (const auto &name : table.names()) {
+            for (std::size_t row = 0; row < table.rows(); ++row) {
+                ASSERT_EQ(parsed.column(name).at(row), table.column(name).at(row));
+            }
+        }
+
+        ASSERT_THROW(Table::fromJson(json->at(0)), WrongTypeException);
+        Json *numbers = Json::fromCppString("[1, 2]");
+        ASSERT_THROW(Table::fromJson(*numbers), WrongTypeException);
+
+        ASSERT_FALSE(Table::fromText("[{\"id\": 1}, 2]", table));
+        ASSERT_EQ(table.rows(), 0u);
+        ASSERT_FALSE(Table::fromText("[{\"id\": 1}", table));
+        ASSERT_TRUE(Table::fromText(" [ ] ", table));
+
+        // scalars after the switch to Json values are kept as such
+        const std::string mixed = "[{\"a\": 1, \"b\": true}, {\"a\": \"x\", \"b\": \"x\"}, {\"a\": 2, \"b\": false}]";
+        ASSERT_TRUE(Table::fromText(mixed, table));
+        ASSERT_EQ(table.column("a").getKind(), Column::Kind::Value);
+        ASSERT_EQ(table.column("a").at(2), 2);
+        ASSERT_EQ(table.column("b").at(2), false);
+
+        Json *records = Json::fromCppString(mixed);
+        Table fromRecords = Table::fromJson(*records);
+        ASSERT_EQ(fromRecords.column("a").at(2), 2);
+        ASSERT_EQ(fromRecords.column("b").at(2), false);
+
+        delete records;
+        delete numbers;
+        delete json;
+    }
+
+    TEST(JSONTestSuite, testAggregation) {
+        // integer sums are exact however large the values
+        std::vector<std::int64_t> integers = { 9223372036854775807LL, 9223372036854775807LL, -4, 7, -9223372036854775807LL - 1, 3 };
+        Aggregate total = aggregate(integers);
+
+        ASSERT_EQ(total.count, 6u);
+        ASSERT_EQ(total.sum, 9223372036854775807.0);
+        ASSERT_EQ(total.min, -9223372036854775808.0);
+        ASSERT_EQ(total.max, 9223372036854775807.0);
+
+        Aggregate filtered = aggregate(integers, { -4, 7 });
+        ASSERT_EQ(filtered.count, 3u);
+        ASSERT_EQ(filtered.sum, 6.0);
+        ASSERT_EQ(filtered.mean(), 2.0);
+        ASSERT_EQ(aggregate(integers, { 0.5, 2.5 }).count, 0u);
+        ASSERT_TRUE(std::isnan(aggregate(integers, { 0.5, 2.5 }).min));
+
+        std::vector<double> doubles = { 0.5, -1.25, 8.0, 2.0, 4.5 };
+        Aggregate decimals = aggregate(doubles, { -1, 10 });
+        ASSERT_EQ(decimals.count, 4u);
+        ASSERT_EQ(decimals.sum, 15.0);
+        ASSERT_EQ(decimals.min, 0.5);
+        ASSERT_EQ(decimals.max, 8.0);
+
+        // large inputs are split across threads
+        std::vector<std::int64_t> many(3 << 20);
+        std::int64_t expected = 0;
+
+        for (std::size_t i = 0; i < many.size(); ++i) {
+            many[i] = (std::int64_t)(i % 1000) - 500;
+            expected += (many[i] >= 0) ? many[i] : 0;
+        }
+
+        ASSERT_EQ(aggregate(many).count, many.size());
+        ASSERT_EQ(aggregate(many, { 0 }).sum, (double)expected);
+        ASSERT_EQ(aggregate(many).min, -500.0);
+
+        // nested paths fan out over Arrays, packed or not
+        Json *json = Json::fromCppString("{\"orders\": [{\"total\": 10, \"items\": [1, 2, 3]}, {\"total\": 2.5, \"items\": [0.5]}, "
+            "{\"total\": \"n/a\", \"items\": []}, {\"items\": [[4], null]}], \"a/b\": [1, 2]}");
+
+        Aggregate totals = aggregate(*json, "/orders/total");
+        ASSERT_EQ(totals.count, 2u);
+        ASSERT_EQ(totals.sum, 12.5);
+        ASSERT_EQ(totals.min, 2.5);
+        ASSERT_EQ(totals.max, 10.0);
+
+        Aggregate items = aggregate(*json, "/orders/items");
+        ASSERT_EQ(items.count, 5u);
+        ASSERT_EQ(items.sum, 10.5);
+        ASSERT_EQ(aggregate(*json, "/orders/items", { 2 }).count, 3u);
+        ASSERT_EQ(aggregate(*json, "/a~1b").sum, 3.0);
+        ASSERT_EQ(aggregate(*json).count, 0u);
+        ASSERT_EQ(aggregate(*json, "/missing").count, 0u);
+        ASSERT_THROW(aggregate(*json, "orders"), std::invalid_argument);
+
+        // columns skip their null rows
+        std::string records = "[";
+
+        for (int i = 0; i < 200; ++i) {
+            records += (i == 0 ? "" : ", ") + std::string(i % 70 == 3 ? "{\"n\": null}" : "{\"n\": " + std::to_string(i) + "}");
+        }
+
+        Table table;
+        ASSERT_TRUE(Table::fromText(records + "]", table));
+
+        Aggregate column = aggregate(table.column("n"));
+        ASSERT_EQ(column.count, 197u);
+        ASSERT_EQ(column.sum, 199.0 * 200 / 2 - 3 - 73 - 143);
+        ASSERT_EQ(column.max, 199.0);
+        ASSERT_EQ(aggregate(table.column("n"), { 100, 149 }).count, 49u);
+
+        delete json;
+    }
+
+    TEST(JSONTestSuite, testWriter) {
+        Writer writer;
+        std::pmr::string name("a name that does not fit a small string buffer");
+
+        writer.beginObject(4)
+            .key("id").value(7)
+            .key("price").value(2.5)
+            .key("tags").beginArray(3).value("a").value(std::move(name)).value(nullptr).endArray()
+            .key("nested").beginObject().key("ok").value(true).endObject()
+            .endObject();
+
+        ASSERT_TRUE(writer.done());
+        Json built = writer.result();
+        ASSERT_FALSE(writer.done());
+
+        Json *parsed = Json::fromCppString("{\"id\": 7, \"price\": 2.5, \"tags\": [\"a\", \"a name that does not fit a small string buffer\", null], "
+            "\"nested\": {\"ok\": true}}");
+
+        ASSERT_EQ(built.size(), 4u);
+        ASSERT_EQ(built.at("tags").size(), 3u);
+        ASSERT_EQ(built.at("tags").at(1), "a name that does not fit a small string buffer");
+        ASSERT_EQ(built.hash(), parsed->hash());
+        ASSERT_TRUE(built == *parsed);
+
+        // calls out of order are rejected without changing the writer
+        writer.beginArray();
+        ASSERT_THROW(writer.endObject(), std::logic_error);
+        ASSERT_THROW(writer.key("x"), std::logic_error);
+        ASSERT_THROW(writer.result(), std::logic_error);
+        writer.beginObject();
+        ASSERT_THROW(writer.value(1), std::logic_error);
+        writer.key("x").value(1).endObject().endArray();
+        ASSERT_THROW(writer.value(2), std::logic_error);
+        ASSERT_EQ(writer.result().at(0).at("x"), 1);
+
+        // streaming writes what operator<< writes for the tree
+        std::ostringstream streamed;
+        Writer streaming(streamed);
+        Writer building;
+
+        for (Writer *target : { &streaming, &building }) {
+            target->beginArray()
+                .value(1).value(-2LL).value(18446744073709551615ULL).value(0.25)
+                .beginObject().key("list").beginArray().value("x").value(false).endArray().endObject()
+                .beginArray().endArray()
+                .value(*parsed)
+                .endArray();
+        }
+
+        std::ostringstream serialized;
+        serialized << building.result();
+
+        ASSERT_TRUE(streaming.done());
+        ASSERT_EQ(streamed.str(), serialized.str());
+        ASSERT_THROW(streaming.result(), std::logic_error);
+
+        delete parsed;
+    }
+
+    TEST(JSONTestSuite, testReusableParser) {
+        std::string message = "{\"method\": \"update\", \"id\": 42, \"params\": {\"values\": [1, 2, 3], \"weights\": [0.5, 1.5], "
+            "\"labels\": [\"a label longer than a small string\", \"b\", true, null], \"ratio\": 0.125, \"big\": 123456789012345678901234567890}}";
+
+        Parser parser;
+        Json *document = parser.parseInArena(message.data(), message.size());
+
+        ASSERT_NE(document, nullptr);
+        ASSERT_EQ(document->at("id"), 42);
+        ASSERT_TRUE(document->at("params").at("values").isPacked());
+
+        std::size_t capacity = parser.getArena().capacity();
+        ASSERT_GT(parser.getArena().used(), 0u);
+
+        // once the parser is warm, messages of the same size allocate nothing
+        for (int i = 0; i < 3; ++i) {
+            Allocations::Usage usage = Allocations::measure([&]() { document = parser.parseInArena(message.data(), message.size()); });
+
+            ASSERT_EQ(usage.allocations, 0u);
+            ASSERT_EQ(parser.getArena().capacity(), capacity);
+        }
+
+        Json *fresh = Json::fromCppString(message);
+        ASSERT_TRUE(*document == *fresh);
+        ASSERT_EQ(document->at("params").at("labels").at(0), "a label longer than a small string");
+
+        std::string malformed = "{\"id\": 42, \"params\": [1, 2}";
+        ASSERT_EQ(parser.parseInArena(malformed.data(), malformed.size()), nullptr);
+        ASSERT_EQ(parser.errorOffset(), malformed.size() - 1);
+
+        // documents larger than the arena grow it once
+        std::string large = "[";
+
+        for (int i = 0; i < 5000; ++i) {
+            large += (i == 0 ? "\"" : ", \"") + std::to_string(i) + " is a string that goes on the arena\"";
+        }
+
+        large += "]";
+        document = parser.parseInArena(large.data(), large.size());
+
+        ASSERT_NE(document, nullptr);
+        ASSERT_EQ(document->size(), 5000u);
+        ASSERT_GT(parser.getArena().capacity(), capacity);
+        ASSERT_EQ(Allocations::measure([&]() { parser.parseInArena(large.data(), large.size()); }).allocations, 0u);
+
+        document = parser.parseInArena(message.data(), message.size());
+        ASSERT_TRUE(*document == *fresh);
+
+        delete fresh;
+    }
+
+    TEST(JSONTestSuite, testDecompression) {
+        // 2000 records compressed with gzip -9
+        static const char gzipped[] =
+                "\x1f\x8b\x08\x00\x00\x00\x00\x00\x02\x03\xed\xc9\xb1\x09\x80\x30\x00\x45\xc1\x55\xc2\xaf\xd3\x0b"
+                "\xae\x12\x52\x44\x04\xb1\xd6\x4e\xdc\xdd\xac\x60\x7f\xdd\x7b\x5c\x7b\x72\xee\x59\xcb\x52\x4b\xee"
+                "\x71\x5c\x33\x5b\x46\xe6\x6d\xe9\x6f\x2d\x18\x63\x8c\x31\xc6\x18\x63\x8c\x31\xc6\x18\x63\x8c\x31"
+                "\xc6\x18\x63\x8c\x31\xc6\x18\x63\x8c\x31\xc6\x18\x63\x8c\x31\xc6\x18\x63\x8c\x31\xc6\x18\x63\x8c"
+                "\x31\xc6\x18\x63\x8c\x31\xc6\x18\x63\x8c\x31\xc6\x18\x63\x8c\x31\xc6\x18\x63\x8c\x31\xc6\x18\x63"
+                "\x8c\x31\xc6\x18\x63\x8c\x31\xc6\x18\x63\x8c\x31\xc6\x18\x63\x8c\x31\xc6\x18\x63\x8c\x31\xc6\x18"
+                "\x63\x8c\x31\xc6\x18\x63\x8c\x31\xc6\x18\x63\x8c\x31\xc6\x18\x63\x8c\x31\xc6\x18\x63\x8c\x31\xc6"
+                "\x18\x63\x8c\x31\xc6\x18\x63\x8c\x31\xc6\x18\x63\x8c\x31\xc6\x18\x63\x8c\x31\xc6\x18\x63\x8c\x31"
+                "\xc6\x18\x63\x8c\x31\xc6\x18\x63\x8c\x31\xc6\x18\x63\x8c\x31\xc6\x3f\xb9\x7f\xde\x57\x07\xbc\x30"
+                "\xf2\x00\x00";
+
+        std::string compressed(gzipped, sizeof(gzipped) - 1);
+        std::string expected = "[";
+
+        for (int i = 0; i < 2000; ++i) {
+            expected += (i == 0 ? "" : ", ") + std::string("{\"id\": 7, \"tags\": [\"a\", \"b\"]}");
+        }
+
+        expected += "]";
+
+        // a frame of one raw block, as zstd stores incompressible input
+        std::string zstd("\x28\xB5\x2F\xFD\x20\x06\x31\x00\x00[1, 2]", 15);
+
+        ASSERT_EQ(detectCodec(compressed), Codec::Gzip);
+        ASSERT_EQ(detectCodec(zstd), Codec::Zstd);
+        ASSERT_EQ(detectCodec(expected), Codec::Plain);
+        ASSERT_TRUE(isSupported(Codec::Plain));
+
+        // a reader that hands out a few bytes at a time
+        auto readerOf = [](std::string input) -> ChunkReader {
+            auto offset = std::make_shared<std::size_t>(0);
+
+            return [input, offset](char *buffer, std::size_t capacity) {
+                std::size_t size = std::min({ capacity, (std::size_t)7, input.size() - *offset });
+                std::memcpy(buffer, input.data() + *offset, size);
+                *offset += size;
+
+                return size;
+            };
+        };
+
+        auto count = [](ChunkReader reader, bool &valid) {
+            std::size_t elements = 0;
+            valid = true;
+
+            for (auto &element : JSON::elements(std::move(reader))) {
+                valid = valid && !element.isInvalid();
+                elements += !element.isInvalid();
+            }
+
+            return elements;
+        };
+
+        bool valid = false;
+        ASSERT_EQ(count(decompressing(readerOf("[1, 2, 3]"), 2, 2), valid), 3u);
+        ASSERT_TRUE(valid);
+
+        if (isSupported(Codec::Gzip)) {
+            std::string text;
+            ASSERT_TRUE(decompress(compressed, text));
+            ASSERT_EQ(text, expected);
+
+            // gzip members can be concatenated
+            text.clear();
+            ASSERT_TRUE(decompress(compressed + compressed, text));
+            ASSERT_EQ(text, expected + expected);
+
+            text = "kept";
+            ASSERT_FALSE(decompress(compressed.substr(0, 100), text));
+            ASSERT_EQ(text, "kept");
+
+            // the parser takes chunks from a ring of two while they are decompressed
+            ASSERT_EQ(count(decompressing(readerOf(compressed), 1024, 2), valid), 2000u);
+            ASSERT_TRUE(valid);
+
+            count(decompressing(readerOf(compressed.substr(0, 100)), 1024, 2), valid);
+            ASSERT_FALSE(valid);
+
+            // all of the text but no CRC and size trailer, or bytes after
+            // the last member, still end in an Invalid element
+            std::string truncated = compressed.substr(0, compressed.size() - 8);
+            ASSERT_FALSE(decompress(truncated, text));
+            ASSERT_EQ(count(decompressing(readerOf(truncated), 1024, 2), valid), 2000u);
+            ASSERT_FALSE(valid);
+
+            ASSERT_FALSE(decompress(compressed + "garbage", text));
+            ASSERT_EQ(count(decompressing(readerOf(compressed + "garbage"), 1024, 2), valid), 2000u);
+            ASSERT_FALSE(valid);
+
+            // a reader dropped early stops the decompressing thread
+            for (auto &element : JSON::elements(decompressing(readerOf(compressed), 64, 2))) {
+                ASSERT_TRUE(element.isObject());
+                break;
+            }
+        }
+
+        std::string text;
+
+        if (isSupported(Codec::Zstd)) {
+            ASSERT_TRUE(decompress(zstd, text));
+            ASSERT_EQ(text, "[1, 2]");
+            ASSERT_EQ(count(decompressing(readerOf(zstd)), valid), 2u);
+            ASSERT_TRUE(valid);
+        } else {
+            ASSERT_FALSE(decompress(zstd, text));
+            count(decompressing(readerOf(zstd)), valid);
+            ASSERT_FALSE(valid);
+        }
+    }
+
+    TEST(JSONTestSuite, testParallelSerializer) {
+        std::string text = "{\"meta\": {\"name\": \"sample\", \"ratios\": [";
+
+        for (int i = 0; i < 300; ++i) {
+            text += (i ? ", " : "") + std::to_string(i) + ".333333333333";
+        }
+
+        text += "]}, \"records\": [";
+
+        for (int i = 0; i < 500; ++i) {
+            text += std::string(i ? ", " : "") + "{\"id\": " + std::to_string(i) + ", \"tags\": [\"a\", " + std::to_string(i * 7) +
+                "], \"nested\": {\"deep\": [" + std::to_string(i) + ", null, true]}}";
+        }
+
+        text += "], \"empty\": [], \"index\": {";
+
+        for (int i = 0; i < 400; ++i) {
+            text += std::string(i ? ", " : "") + "\"key" + std::to_string(i) + "\": [" + std::to_string(i) + ", \"v\"]";
+        }
+
+        text += "}}";
+
+        Json *json = Json::fromCppString(text);
+        ASSERT_TRUE(json->at("meta").at("ratios").isPacked());
+
+        SerializeOptions options;
+        options.threads = 4;
+        options.chunkSize = 16;
+
+        // the bytes match operator<<, also with the precision of the stream
+        for (std::streamsize precision : { 6, 17 }) {
+            std::ostringstream expected;
+            std::ostringstream written;
+            expected.precision(precision);
+            written.precision(precision);
+
+            expected << *json;
+            serialize(written, *json, options);
+            ASSERT_EQ(written.str(), expected.str());
+        }
+
+        std::ostringstream expected;
+        expected << *json;
+
+        // small documents and one thread take the plain path
+        std::ostringstream small;
+        serialize(small, json->at("empty"), options);
+        ASSERT_EQ(small.str(), "[ ]");
+
+        options.threads = 1;
+        std::ostringstream single;
+        serialize(single, *json, options);
+        ASSERT_EQ(single.str(), expected.str());
+
+        // a descriptor gets the buffers through writev
+        options.threads = 4;
+        std::FILE *file = std::tmpfile();
+        ASSERT_NE(file, nullptr);
+        ASSERT_TRUE(serialize(fileno(file), *json, options));
+
+        std::string read(expected.str().size() + 1, '\0');
+        std::rewind(file);
+        read.resize(std::fread(read.data(), 1, read.size(), file));
+        std::fclose(file);
+        ASSERT_EQ(read, expected.str());
+
+        ASSERT_FALSE(serialize(-1, *json, options));
+
+        delete json;
+    }
+
+    TEST(JSONTestSuite, testOffsetIndex) {
+        std::string text = " [";
+
+        for (int i = 0; i < 100; ++i) {
+            text += std::string(i ? ",\n  " : "") + "{\"name\": \"a, \\\"quoted\\\" ]name " + std::to_string(i) + "\", \"id\": " + std::to_string(i * 3) +
+                ", \"tags\": [\"x\", {\"id\": -1}]}";
+        }
+
+        text += ", 42, \"tail\", [\"id\"], {\"id\": \"first\"}, {\"id\": \"first\"}]\n";
+
+        OffsetIndex index;
+        ASSERT_TRUE(OffsetIndex::build(text, index, "id"));
+        ASSERT_EQ(index.size(), 105u);
+        ASSERT_EQ(text[index.offset(0)], '{');
+        ASSERT_EQ(text.substr(index.offset(100), 2), "42");
+
+        // keys are the text of scalars, nested members do not count
+        std::size_t element = 0;
+        ASSERT_TRUE(index.find("27", element));
+        ASSERT_EQ(element, 9u);
+        ASSERT_FALSE(index.find("-1", element));
+        ASSERT_TRUE(index.find("first", element));
+        ASSERT_EQ(element, 103u);
+
+        ASSERT_FALSE(OffsetIndex::build("[1, 2", index));
+        ASSERT_FALSE(OffsetIndex::build("[1 2]", index));
+        ASSERT_FALSE(OffsetIndex::build("{\"id\": 1}", index));
+        ASSERT_FALSE(OffsetIndex::build("[1] 2", index));
+        ASSERT_TRUE(OffsetIndex::build(" [ ] ", index));
+        ASSERT_EQ(index.size(), 0u);
+
+        std::filesystem::path directory = std::filesystem::temp_directory_path() / ("json-offsets-" + std::to_string(::getpid()));
+        std::filesystem::create_directories(directory);
+        std::filesystem::path path = directory / "records.json";
+        std::filesystem::path sidecar = directory / "records.json.idx";
+
+        std::ofstream(path, std::ios::binary) << text;
+        ASSERT_TRUE(OffsetIndex::buildFile(path, sidecar, "name"));
+
+        IndexedFile file;
+        ASSERT_TRUE(file.open(path, sidecar));
+        ASSERT_EQ(file.size(), 105u);
+        ASSERT_EQ(file.getIndex().keyField(), "name");
+
+        // only the requested elements are parsed
+        Json record = file.find("a, \"quoted\" ]name 57");
+        ASSERT_TRUE(record.isObject());
+        ASSERT_EQ(record.at("id"), 171);
+        ASSERT_EQ(file.element(100), 42);
+        ASSERT_TRUE(file.element(105).isInvalid());
+        ASSERT_TRUE(file.find("missing").isInvalid());
+
+        std::vector<Json> tail = file.range(99, 10);
+        ASSERT_EQ(tail.size(), 6u);
+        ASSERT_EQ(tail[0].at("id"), 297);
+        ASSERT_EQ((std::string)tail[2], "tail");
+        ASSERT_TRUE(tail[3].isArray());
+
+        // a sidecar of another version of the file is refused
+        std::ofstream(path, std::ios::binary) << text << ' ';
+        ASSERT_FALSE(file.open(path, sidecar));
+        ASSERT_EQ(file.size(), 0u);
+
+        std::ofstream(sidecar, std::ios::binary) << "JSONIDX1 truncated";
+        ASSERT_FALSE(OffsetIndex::load(sidecar, index));
+
+        std::filesystem::remove_all(directory);
+    }
+
+    TEST(JSONTestSuite, testKeyHandles) {
+        static constexpr Key price{ "price_in_the_smallest_unit_of_currency" };
+        static constexpr Key discount{ "discount_in_the_smallest_unit_of_currency" };
+        static_assert(price.hash() == Key::hashOf("price_in_the_smallest_unit_of_currency"));
+
+        const Json *json = Json::fromCppString("{\"price_in_the_smallest_unit_of_currency\": 1250, \"name\": \"a record with a long name\"}");
+        const Json &record = *json;
+
+        // lookups by Key or by string view neither allocate nor throw on a miss
+        Allocations::Usage usage = Allocations::measure([&]() {
+            ASSERT_TRUE(record.contains(price));
+            ASSERT_FALSE(record.contains(discount));
+            ASSERT_EQ(record.find(discount), nullptr);
+            ASSERT_EQ(*record.find(price), 1250);
+            ASSERT_EQ(record.at(price), 1250);
+            ASSERT_EQ(&record.at("price_in_the_smallest_unit_of_currency"), record.find(price));
+            ASSERT_TRUE(record.contains(std::string_view("name")));
+            ASSERT_FALSE(record.contains(std::string_view("nam")));
+        });
+
+        ASSERT_EQ(usage.allocations, 0u);
+        ASSERT_THROW(record.at(discount), std::out_of_range);
+        ASSERT_THROW(record[discount], std::out_of_range);
+        ASSERT_EQ(record[price], 1250);
+
+        // names in other string types still work
+        std::string name = "name";
+        ASSERT_EQ(record.at(name), "a record with a long name");
+        ASSERT_EQ(Json(Json::Type::Array).find(price), nullptr);
+        ASSERT_THROW(Json(Json::Type::Array).at(price), WrongTypeException);
+
+        // a modification through a Key leaves copies untouched
+        Json copy = record;
+        copy.at(price) = 990;
+        ASSERT_EQ(copy.at(price), 990);
+        ASSERT_EQ(record.at(price), 1250);
+
+        delete json;
+    }
+
+    TEST(JSONTestSuite, testMemoryUsage) {
+        std::size_t before = Memory::liveBytes();
+        const std::string longText(100, 'x');
+
+        Json *json = Json::fromCppString("{\"samples\": [1, 2, 3, 4], \"label\": \"short\", \"text\": \"" + longText +
+            "\", \"big\": 123456789012345678901234567890, \"records\": [{\"ok\": true}, null]}");
+
+        // the gauge sees the nodes of the document, and only those
+        ASSERT_GT(Memory::liveBytes(), before);
+
+        MemoryUsage usage = json->memoryUsage();
+        ASSERT_EQ(usage[Json::Type::Object].values, 2u);
+        ASSERT_EQ(usage[Json::Type::Array].values, 2u);
+        ASSERT_EQ(usage[Json::Type::String].values, 2u);
+        ASSERT_EQ(usage[Json::Type::Integer].values, 1u);
+        ASSERT_EQ(usage[Json::Type::Boolean].values, 1u);
+        ASSERT_EQ(usage[Json::Type::Null].values, 1u);
+
+        // short strings are part of their node, packed numbers are payload
+        ASSERT_EQ(usage[Json::Type::String].payload, longText.size());
+        ASSERT_EQ(usage[Json::Type::Array].payload, 4 * sizeof(std::int64_t));
+        ASSERT_EQ(usage[Json::Type::Integer].payload, 30u);
+        ASSERT_GT(usage[Json::Type::Object].hashing, 0u);
+        ASSERT_EQ(usage[Json::Type::Array].hashing, 0u);
+        ASSERT_EQ(usage.shared, 0u);
+        ASSERT_GE(Memory::liveBytes() - before, usage[Json::Type::String].payload + usage[Json::Type::Array].payload);
+
+        // shared nodes are counted once
+        Json pair(Json::Type::Array);
+        pair.append(*json);
+        pair.append(*json);
+
+        MemoryUsage shared = pair.memoryUsage();
+        ASSERT_EQ(shared.shared, 1u);
+        ASSERT_EQ(shared[Json::Type::String].total(), usage[Json::Type::String].total());
+
+        pair = Json();
+        delete json;
+        ASSERT_EQ(Memory::liveBytes(), before);
+
+        // arenas count the blocks they keep
+        {
+            Arena arena(4096);
+            ASSERT_NE(arena.allocate(100), nullptr);
+            ASSERT_EQ(Memory::liveBytes(), before + arena.capacity());
+        }
+
+        ASSERT_EQ(Memory::liveBytes(), before);
+    }
+
+    TEST(JSONTestSuite, testDocumentCache) {
+        namespace fs = std::filesystem;
+
+        fs::path directory = fs::temp_directory_path() / ("json-cache-" + std::to_string(::getpid()));
+        fs::remove_all(directory);
+
+        const std::string content = "{\"name\": \"cached\", \"values\": [1, 2, 3]}";
+        const fs::file_time_type modified = fs::file_time_type::clock::now() - std::chrono::hours(1);
+        Json *json = Json::fromCppString(content);
+
+        auto entries = [&directory]() {
+            std::vector<fs::path> paths;
+
+            for (const auto &file : fs::directory_iterator(directory)) {
+                paths.push_back(file.path());
+            }
+
+            return paths;
+        };
+
+        {
+            DocumentCache cache(directory, 1 << 20);
+            ASSERT_EQ(cache.load(content, modified), nullptr);
+
+            cache.store(content, modified, *json);
+            Json *hit = cache.load(content, modified);
+            ASSERT_NE(hit, nullptr);
+            ASSERT_TRUE(*hit == *json);
+            delete hit;
+
+            // a changed file misses, by content or by modification time
+            ASSERT_EQ(cache.load(content + " ", modified), nullptr);
+            ASSERT_EQ(cache.load(content, modified + std::chrono::seconds(1)), nullptr);
+
+            // a corrupt or truncated entry is a miss, not a wrong document
+            ASSERT_EQ(entries().size(), 1u);
+            fs::path entry = entries()[0];
+            std::string bytes;
+            {
+                std::ifstream file(entry, std::ios::binary);
+                bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            }
+
+            std::string corrupt = bytes;
+            corrupt.back() ^= 0x01;
+            std::ofstream(entry, std::ios::binary | std::ios::trunc) << corrupt;
+            ASSERT_EQ(cache.load(content, modified), nullptr);
+
+            std::ofstream(entry, std::ios::binary | std::ios::trunc) << bytes.substr(0, 10);
+            ASSERT_EQ(cache.load(content, modified), nullptr);
+
+            std::ofstream(entry, std::ios::binary | std::ios::trunc) << bytes;
+            hit = cache.load(content, modified);
+            ASSERT_NE(hit, nullptr);
+            delete hit;
+        }
+
+        fs::remove_all(directory);
+
+        // the least recently used entries go once the directory is too large
+        {
+            const std::string other = "{\"name\": \"other\", \"values\": [4, 5, 6]}";
+            Json *otherJson = Json::fromCppString(other);
+
+            DocumentCache unbounded(directory, 1 << 20);
+            unbounded.store(content, modified, *json);
+            std::uintmax_t size = fs::file_size(entries()[0]);
+            fs::last_write_time(entries()[0], fs::file_time_type::clock::now() - std::chrono::hours(2));
+
+            DocumentCache bounded(directory, size + size / 2);
+            bounded.store(other, modified, *otherJson);
+            ASSERT_EQ(entries().size(), 1u);
+            ASSERT_EQ(bounded.load(content, modified), nullptr);
+
+            Json *hit = bounded.load(other, modified);
+            ASSERT_NE(hit, nullptr);
+            ASSERT_TRUE(*hit == *otherJson);
+
+            delete hit;
+            delete otherJson;
+        }
+
+        fs::remove_all(directory);
+        delete json;
+    }
+};